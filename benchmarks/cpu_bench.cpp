@@ -0,0 +1,87 @@
+#include "test_system.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+// Tight ALU loop, typical of what games spend their time in.
+const std::vector<uint8_t> program =
+{
+    0x06, 0x00,       // 0x100: ld b, 0
+    0x3C,             // 0x102: inc a
+    0x80,             // 0x103: add a, b
+    0xA9,             // 0x104: xor c
+    0x57,             // 0x105: ld d, a
+    0xCB, 0x37,       // 0x106: swap a
+    0x05,             // 0x108: dec b
+    0x20, 0xF7,       // 0x109: jr nz, 0x102
+    0xC3, 0x00, 0x01  // 0x10B: jp 0x100
+};
+
+// Waits for VBlank in HALT, the way most games idle between frames.
+const std::vector<uint8_t> haltProgram =
+{
+    0x3E, 0x01,       // 0x100: ld a, 0x01
+    0xE0, 0xFF,       // 0x102: ldh (0xFF), a  ; IE = VBlank
+    0xFB,             // 0x104: ei
+    0x76,             // 0x105: halt
+    0x18, 0xFD        // 0x106: jr 0x105
+};
+
+std::string writeRom(const std::vector<uint8_t>& code)
+{
+    std::vector<uint8_t> rom = tests::romWithCode(code);
+    rom[0x40] = 0xD9; // VBlank handler: reti
+
+    return tests::writeRom("cpu_bench", rom);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    constexpr uint64_t nbCycles = 50'000'000;
+
+    // "block" runs the decoded block engine instead of the interpreter,
+    // "halt" runs a program idling in HALT.
+    bool blockEngine = false;
+    bool halting = false;
+    for (int i = 1; i < argc; i++)
+    {
+        blockEngine |= strcmp(argv[i], "block") == 0;
+        halting |= strcmp(argv[i], "halt") == 0;
+    }
+
+    auto system = std::make_unique<tests::System>(writeRom(halting ? haltProgram : program));
+    cpu::Processor& processor = system->processor;
+
+    auto start = std::chrono::steady_clock::now();
+    while (processor.getCycles() < nbCycles)
+    {
+        if (blockEngine)
+        {
+            processor.runNextBlock();
+        }
+        else
+        {
+            processor.runNextInstruction(false);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+#ifdef ANOTHERGB_THREADED_DISPATCH
+    const char* dispatch = "switch";
+#else
+    const char* dispatch = "table";
+#endif
+    printf("program=%s engine=%s dispatch=%s cycles=%llu time=%.3fs Mcycles/s=%.2f\n",
+        halting ? "halt" : "alu", blockEngine ? "block" : "interpreter", dispatch,
+        (unsigned long long)processor.getCycles(), seconds, processor.getCycles() / seconds / 1e6);
+
+    return 0;
+}
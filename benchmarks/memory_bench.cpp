@@ -0,0 +1,52 @@
+#include "test_system.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace
+{
+std::string writeRom()
+{
+    std::vector<uint8_t> rom(0x8000, 0);
+    for (size_t i = 0; i < rom.size(); i++)
+    {
+        rom[i] = (uint8_t)(i * 7);
+    }
+
+    return tests::writeRom("memory_bench", rom);
+}
+
+template<typename Access>
+void run(const char* name, Access access)
+{
+    constexpr uint32_t nbAccesses = 100'000'000;
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < nbAccesses; i++)
+    {
+        sum += access(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf("access=%s ns/access=%.2f (checksum %u)\n", name, seconds * 1e9 / nbAccesses, sum);
+}
+}
+
+int main()
+{
+    auto system = std::make_unique<tests::System>(writeRom());
+    Memory& memory = system->memory;
+
+    run("rom_read8", [&](uint32_t i) { return memory.read8(i & 0x7FFF); });
+    run("wram_write8", [&](uint32_t i) { memory.write8(0xC000 | (i & 0x1FFF), (uint8_t)i); return 0u; });
+    run("wram_read8", [&](uint32_t i) { return memory.read8(0xC000 | (i & 0x1FFF)); });
+    run("wram_read16", [&](uint32_t i) { return memory.read16(0xC000 | (i & 0x1FFE)); });
+    run("hram_read8", [&](uint32_t i) { return memory.read8(0xFF80 | (i & 0x7F)); });
+    run("io_read8", [&](uint32_t i) { return memory.read8(0xFF40 | (i & 0x0F)); });
+
+    return 0;
+}
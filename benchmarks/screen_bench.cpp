@@ -0,0 +1,65 @@
+#include "test_system.h"
+#include "video/pixel_kernels.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+// Runs the PPU alone, without the processor, and reports the cost of a
+// visible line (mode changes included).
+void run(const char* name, Memory& memory, uint8_t lcdc, bool scroll = true)
+{
+    constexpr int nbFrames = 2000;
+    utils::Scheduler& scheduler = memory.getScheduler();
+    memory.write8(0xFF40, lcdc);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < nbFrames; frame++)
+    {
+        // Scroll a bit so that lines don't all start on a tile boundary, and
+        // all of them change.
+        if (scroll)
+        {
+            memory.write8(0xFF43, (uint8_t)frame);
+        }
+        scheduler.advance(70224);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf("layers=%s ns/line=%.1f\n", name, seconds * 1e9 / (nbFrames * 144.0));
+}
+}
+
+int main()
+{
+    auto system = std::make_unique<tests::System>(tests::writeRom("screen_bench", std::vector<uint8_t>(0x8000, 0)));
+    Memory& memory = system->memory;
+
+    // Random tiles, maps and objects.
+    std::mt19937 rng(0);
+    for (uint16_t addr = 0x8000; addr < 0xA000; addr++)
+    {
+        memory.write8(addr, (uint8_t)rng());
+    }
+    for (uint16_t addr = 0xFE00; addr < 0xFEA0; addr++)
+    {
+        memory.write8(addr, (uint8_t)rng());
+    }
+    memory.write8(0xFF47, 0xE4);
+    memory.write8(0xFF48, 0xE4);
+    memory.write8(0xFF4A, 40);
+    memory.write8(0xFF4B, 87);
+
+    printf("kernels=%s\n", video::PixelKernels::best().name);
+    run("bg", memory, 0x91);
+    run("bg+window", memory, 0xB1);
+    run("bg+window+obj", memory, 0xB3);
+    run("static", memory, 0xB3, false);
+
+    return 0;
+}
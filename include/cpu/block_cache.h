@@ -0,0 +1,104 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace cpu
+{
+class Processor;
+class Registers;
+
+// One pre-decoded instruction: the handler to call and its immediates, so that
+// running it needs neither an opcode fetch nor a table lookup.
+struct DecodedInstruction
+{
+    int (*execute)(Processor&);
+    uint16_t operand;
+    uint16_t nextPC;
+    uint16_t opCode; // 0xCBxx for prefixed instructions
+};
+
+// Straight-line run of instructions ending on a control flow instruction.
+struct Block
+{
+    uint16_t startPC = 0;
+    uint16_t endPC = 0; // One past the last byte of the block
+    std::vector<DecodedInstruction> instructions;
+
+    // Loop polling memory that only an event can change, see
+    // Processor::skipIdleLoop.
+    bool idleLoop = false;
+
+    // Native translation, see Jit.
+    uint32_t executionCount = 0;
+    int (*native)(Processor*, Registers*, int) = nullptr;
+    bool untranslatable = false;
+};
+
+// Decoded blocks keyed by (ROM bank, PC). Blocks decoded from WRAM/HRAM are
+// dropped as soon as one of their bytes is written.
+class BlockCache
+{
+public:
+    static constexpr size_t maxBlockSize = 64;
+
+    Block* find(uint16_t bank, uint16_t pc);
+    Block& insert(uint16_t bank, Block&& block);
+
+    // Called for every write to 0xC000-0xFFFF.
+    void onWrite(uint16_t addr)
+    {
+        if (m_codePages[addr >> 8])
+        {
+            invalidate(addr);
+        }
+    }
+
+    void clear();
+
+    // Called when a ROM bank is switched, the rest of a running block may
+    // have been decoded from the previous bank.
+    void onBankSwitch()
+    {
+        m_generation++;
+    }
+
+    // Incremented every time blocks are dropped or banks switched, lets a
+    // running block notice it overwrote or unmapped itself.
+    uint32_t generation() const
+    {
+        return m_generation;
+    }
+
+    static bool isCacheable(uint16_t pc)
+    {
+        return pc < 0x8000 || (pc >= 0xC000 && pc < 0xE000) || (pc >= 0xFF80 && pc < 0xFFFF);
+    }
+
+private:
+    static bool isRam(uint16_t pc)
+    {
+        return pc >= 0x8000;
+    }
+
+    static uint32_t key(uint16_t bank, uint16_t pc)
+    {
+        return ((uint32_t)bank << 16) | pc;
+    }
+
+    void invalidate(uint16_t addr);
+
+    std::unordered_map<uint32_t, std::unique_ptr<Block>> m_romBlocks;
+    std::unordered_map<uint16_t, std::unique_ptr<Block>> m_ramBlocks;
+
+    // Invalidated blocks are kept alive until the next lookup, the block being
+    // executed may be the one that got invalidated.
+    std::vector<std::unique_ptr<Block>> m_retired;
+
+    std::bitset<256> m_codePages;
+    uint32_t m_generation = 0;
+};
+}
@@ -29,4 +29,30 @@ namespace cpu
 
         return { rA, rB };
     }
+
+    // Size in bytes of an instruction, opcode and immediates included.
+    constexpr uint8_t instructionLength(uint8_t opcode)
+    {
+        switch (opcode)
+        {
+        case 0x01: case 0x11: case 0x21: case 0x31: // ld rr, nn
+        case 0x08:                                  // ld (nn), SP
+        case 0xC2: case 0xC3: case 0xCA: case 0xD2: case 0xDA: // jp
+        case 0xC4: case 0xCC: case 0xCD: case 0xD4: case 0xDC: // call
+        case 0xEA: case 0xFA:                       // ld (nn), A / ld A, (nn)
+            return 3;
+        case 0x06: case 0x0E: case 0x16: case 0x1E:
+        case 0x26: case 0x2E: case 0x36: case 0x3E: // ld r, n
+        case 0x10:                                  // stop
+        case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // jr
+        case 0xC6: case 0xCE: case 0xD6: case 0xDE:
+        case 0xE6: case 0xEE: case 0xF6: case 0xFE: // alu A, n
+        case 0xE0: case 0xF0:                       // ldh
+        case 0xE8: case 0xF8:                       // add SP, e / ld HL, SP+e
+        case 0xCB:
+            return 2;
+        default:
+            return 1;
+        }
+    }
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "block_cache.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cpu
+{
+class Processor;
+class Registers;
+
+// Translates hot ROM blocks into x86-64 code (System V ABI).
+//
+// Loads, 8-bit ALU operations, inc/dec and jr/jp run natively with the SM83
+// registers kept in host registers for the whole block. Every other
+// instruction spills them back and calls its interpreter handler. The
+// generated function returns the number of cycles spent since the clocks were
+// last synced. That happens before every handler accessing memory, so that it
+// sees the same timing as the decoded block, and after every handler.
+//
+// Like the decoded block, the native block leaves at the instruction boundary
+// where the interpreter would service an interrupt: once the next scheduled
+// event is due, or when a handler made an interrupt pending or switched
+// banks.
+//
+// Blocks running from RAM (possibly self modifying) or accessing I/O registers
+// through ldh / ld (nn) are not translated and keep running on the
+// interpreter.
+class Jit
+{
+public:
+    // Takes the cycles until the next scheduled event.
+    using NativeBlock = int (*)(Processor*, Registers*, int);
+    using Fallback = int (*)(Processor&, const DecodedInstruction*);
+    // Advances the clocks by the cycles run natively so far. Returns the
+    // cycles until the next event, 0 when the block has to leave at once.
+    using ClockSync = int (*)(Processor&, int);
+
+    // Number of runs of a block before it gets translated.
+    static constexpr uint32_t hotThreshold = 16;
+
+    Jit();
+    ~Jit();
+
+    Jit(const Jit&) = delete;
+    Jit& operator=(const Jit&) = delete;
+
+    // Returns nullptr when the block can't be translated.
+    NativeBlock compile(const Block& block, Fallback fallback, ClockSync sync);
+
+    size_t compiledBlocks() const
+    {
+        return m_compiledBlocks;
+    }
+
+private:
+    static bool isTranslatable(const Block& block);
+
+    uint8_t* m_code = nullptr;
+    size_t m_codeUsed = 0;
+    size_t m_compiledBlocks = 0;
+};
+}
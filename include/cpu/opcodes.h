@@ -0,0 +1,511 @@
+#pragma once
+
+// Opcode to handler mapping, expanded by X(opcode, handler).
+// Shared by the member function pointer tables and the switch dispatcher so both
+// stay in sync. Opcodes missing from the lists are dispatched to unhandled().
+
+#define GB_OPCODES(X) \
+    X(0x00, nop) \
+    X(0x01, ld_rr_nn<Registers::BC>) \
+    X(0x02, ld_r16_A<Registers::BC>) \
+    X(0x03, inc_rr<Registers::BC>) \
+    X(0x04, inc_r<Registers::B>) \
+    X(0x05, dec_r<Registers::B>) \
+    X(0x06, ld_r_n_8<0x06>) \
+    X(0x07, rlca) \
+    X(0x08, ld_nn_SP) \
+    X(0x09, add_HL_rr<Registers::BC>) \
+    X(0x0A, ld_A_r16<Registers::BC>) \
+    X(0x0B, dec_rr<Registers::BC>) \
+    X(0x0C, inc_r<Registers::C>) \
+    X(0x0D, dec_r<Registers::C>) \
+    X(0x0E, ld_r_n_8<0x0E>) \
+    X(0x0F, rrca) \
+    X(0x10, stop) \
+    X(0x11, ld_rr_nn<Registers::DE>) \
+    X(0x12, ld_r16_A<Registers::DE>) \
+    X(0x13, inc_rr<Registers::DE>) \
+    X(0x14, inc_r<Registers::D>) \
+    X(0x15, dec_r<Registers::D>) \
+    X(0x16, ld_r_n_8<0x16>) \
+    X(0x17, rla) \
+    X(0x18, jr_e) \
+    X(0x19, add_HL_rr<Registers::DE>) \
+    X(0x1A, ld_A_r16<Registers::DE>) \
+    X(0x1B, dec_rr<Registers::DE>) \
+    X(0x1C, inc_r<Registers::E>) \
+    X(0x1D, dec_r<Registers::E>) \
+    X(0x1E, ld_r_n_8<0x1E>) \
+    X(0x1F, rra) \
+    X(0x20, jr_ncc_n<Registers::Flag::Z>) \
+    X(0x21, ld_rr_nn<Registers::HL>) \
+    X(0x22, ld_HLi_A) \
+    X(0x23, inc_rr<Registers::HL>) \
+    X(0x24, inc_r<Registers::H>) \
+    X(0x25, dec_r<Registers::H>) \
+    X(0x26, ld_r_n_8<0x26>) \
+    X(0x27, daa) \
+    X(0x28, jr_cc_n<Registers::Flag::Z>) \
+    X(0x29, add_HL_rr<Registers::HL>) \
+    X(0x2A, ld_A_HLi) \
+    X(0x2B, dec_rr<Registers::HL>) \
+    X(0x2C, inc_r<Registers::L>) \
+    X(0x2D, dec_r<Registers::L>) \
+    X(0x2E, ld_r_n_8<0x2E>) \
+    X(0x2F, cpl) \
+    X(0x30, jr_ncc_n<Registers::Flag::C>) \
+    X(0x31, ld_SP_nn) \
+    X(0x32, ld_HLd_A) \
+    X(0x33, inc_SP) \
+    X(0x34, inc_HL) \
+    X(0x35, dec_HL) \
+    X(0x36, ld_HL_n_8<0x36>) \
+    X(0x37, scf) \
+    X(0x38, jr_cc_n<Registers::Flag::C>) \
+    X(0x39, add_HL_SP) \
+    X(0x3A, ld_A_HLd) \
+    X(0x3B, dec_SP) \
+    X(0x3C, inc_r<Registers::A>) \
+    X(0x3D, dec_r<Registers::A>) \
+    X(0x3E, ld_r_n_8<0x3E>) \
+    X(0x3F, ccf) \
+    X(0x40, ld_r_r_8<0x40>) \
+    X(0x41, ld_r_r_8<0x41>) \
+    X(0x42, ld_r_r_8<0x42>) \
+    X(0x43, ld_r_r_8<0x43>) \
+    X(0x44, ld_r_r_8<0x44>) \
+    X(0x45, ld_r_r_8<0x45>) \
+    X(0x46, ld_r_HL<0x46>) \
+    X(0x47, ld_r_r_8<0x47>) \
+    X(0x48, ld_r_r_8<0x48>) \
+    X(0x49, ld_r_r_8<0x49>) \
+    X(0x4A, ld_r_r_8<0x4A>) \
+    X(0x4B, ld_r_r_8<0x4B>) \
+    X(0x4C, ld_r_r_8<0x4C>) \
+    X(0x4D, ld_r_r_8<0x4D>) \
+    X(0x4E, ld_r_HL<0x4E>) \
+    X(0x4F, ld_r_r_8<0x4F>) \
+    X(0x50, ld_r_r_8<0x50>) \
+    X(0x51, ld_r_r_8<0x51>) \
+    X(0x52, ld_r_r_8<0x52>) \
+    X(0x53, ld_r_r_8<0x53>) \
+    X(0x54, ld_r_r_8<0x54>) \
+    X(0x55, ld_r_r_8<0x55>) \
+    X(0x56, ld_r_HL<0x56>) \
+    X(0x57, ld_r_r_8<0x57>) \
+    X(0x58, ld_r_r_8<0x58>) \
+    X(0x59, ld_r_r_8<0x59>) \
+    X(0x5A, ld_r_r_8<0x5A>) \
+    X(0x5B, ld_r_r_8<0x5B>) \
+    X(0x5C, ld_r_r_8<0x5C>) \
+    X(0x5D, ld_r_r_8<0x5D>) \
+    X(0x5E, ld_r_HL<0x5E>) \
+    X(0x5F, ld_r_r_8<0x5F>) \
+    X(0x60, ld_r_r_8<0x60>) \
+    X(0x61, ld_r_r_8<0x61>) \
+    X(0x62, ld_r_r_8<0x62>) \
+    X(0x63, ld_r_r_8<0x63>) \
+    X(0x64, ld_r_r_8<0x64>) \
+    X(0x65, ld_r_r_8<0x65>) \
+    X(0x66, ld_r_HL<0x66>) \
+    X(0x67, ld_r_r_8<0x67>) \
+    X(0x68, ld_r_r_8<0x68>) \
+    X(0x69, ld_r_r_8<0x69>) \
+    X(0x6A, ld_r_r_8<0x6A>) \
+    X(0x6B, ld_r_r_8<0x6B>) \
+    X(0x6C, ld_r_r_8<0x6C>) \
+    X(0x6D, ld_r_r_8<0x6D>) \
+    X(0x6E, ld_r_HL<0x6E>) \
+    X(0x6F, ld_r_r_8<0x6F>) \
+    X(0x70, ld_HL_r<0x70>) \
+    X(0x71, ld_HL_r<0x71>) \
+    X(0x72, ld_HL_r<0x72>) \
+    X(0x73, ld_HL_r<0x73>) \
+    X(0x74, ld_HL_r<0x74>) \
+    X(0x75, ld_HL_r<0x75>) \
+    X(0x76, halt) \
+    X(0x77, ld_HL_r<0x77>) \
+    X(0x78, ld_r_r_8<0x78>) \
+    X(0x79, ld_r_r_8<0x79>) \
+    X(0x7A, ld_r_r_8<0x7A>) \
+    X(0x7B, ld_r_r_8<0x7B>) \
+    X(0x7C, ld_r_r_8<0x7C>) \
+    X(0x7D, ld_r_r_8<0x7D>) \
+    X(0x7E, ld_r_HL<0x7E>) \
+    X(0x7F, ld_r_r_8<0x7F>) \
+    X(0x80, add_r<Registers::B>) \
+    X(0x81, add_r<Registers::C>) \
+    X(0x82, add_r<Registers::D>) \
+    X(0x83, add_r<Registers::E>) \
+    X(0x84, add_r<Registers::H>) \
+    X(0x85, add_r<Registers::L>) \
+    X(0x86, add_HL) \
+    X(0x87, add_r<Registers::A>) \
+    X(0x88, adc_r<Registers::B>) \
+    X(0x89, adc_r<Registers::C>) \
+    X(0x8A, adc_r<Registers::D>) \
+    X(0x8B, adc_r<Registers::E>) \
+    X(0x8C, adc_r<Registers::H>) \
+    X(0x8D, adc_r<Registers::L>) \
+    X(0x8E, adc_HL) \
+    X(0x8F, adc_r<Registers::A>) \
+    X(0x90, sub_r<Registers::B>) \
+    X(0x91, sub_r<Registers::C>) \
+    X(0x92, sub_r<Registers::D>) \
+    X(0x93, sub_r<Registers::E>) \
+    X(0x94, sub_r<Registers::H>) \
+    X(0x95, sub_r<Registers::L>) \
+    X(0x96, sub_HL) \
+    X(0x97, sub_r<Registers::A>) \
+    X(0x98, sbc_r<Registers::B>) \
+    X(0x99, sbc_r<Registers::C>) \
+    X(0x9A, sbc_r<Registers::D>) \
+    X(0x9B, sbc_r<Registers::E>) \
+    X(0x9C, sbc_r<Registers::H>) \
+    X(0x9D, sbc_r<Registers::L>) \
+    X(0x9E, sbc_HL) \
+    X(0x9F, sbc_r<Registers::A>) \
+    X(0xA0, and_r<Registers::B>) \
+    X(0xA1, and_r<Registers::C>) \
+    X(0xA2, and_r<Registers::D>) \
+    X(0xA3, and_r<Registers::E>) \
+    X(0xA4, and_r<Registers::H>) \
+    X(0xA5, and_r<Registers::L>) \
+    X(0xA6, and_HL) \
+    X(0xA7, and_r<Registers::A>) \
+    X(0xA8, xor_r<Registers::B>) \
+    X(0xA9, xor_r<Registers::C>) \
+    X(0xAA, xor_r<Registers::D>) \
+    X(0xAB, xor_r<Registers::E>) \
+    X(0xAC, xor_r<Registers::H>) \
+    X(0xAD, xor_r<Registers::L>) \
+    X(0xAE, xor_HL) \
+    X(0xAF, xor_r<Registers::A>) \
+    X(0xB0, or_r<Registers::B>) \
+    X(0xB1, or_r<Registers::C>) \
+    X(0xB2, or_r<Registers::D>) \
+    X(0xB3, or_r<Registers::E>) \
+    X(0xB4, or_r<Registers::H>) \
+    X(0xB5, or_r<Registers::L>) \
+    X(0xB6, or_HL) \
+    X(0xB7, or_r<Registers::A>) \
+    X(0xB8, cp_r<Registers::B>) \
+    X(0xB9, cp_r<Registers::C>) \
+    X(0xBA, cp_r<Registers::D>) \
+    X(0xBB, cp_r<Registers::E>) \
+    X(0xBC, cp_r<Registers::H>) \
+    X(0xBD, cp_r<Registers::L>) \
+    X(0xBE, cp_HL) \
+    X(0xBF, cp_r<Registers::A>) \
+    X(0xC0, ret_ncc<Registers::Flag::Z>) \
+    X(0xC1, pop_rr<Registers::BC>) \
+    X(0xC2, jp_ncc_nn<Registers::Flag::Z>) \
+    X(0xC3, jp_nn) \
+    X(0xC4, call_ncc_nn<Registers::Flag::Z>) \
+    X(0xC5, push_rr<Registers::BC>) \
+    X(0xC6, add_n) \
+    X(0xC7, rst<0x00>) \
+    X(0xC8, ret_cc<Registers::Flag::Z>) \
+    X(0xC9, ret) \
+    X(0xCA, jp_cc_nn<Registers::Flag::Z>) \
+    X(0xCB, cb) \
+    X(0xCC, call_cc_nn<Registers::Flag::Z>) \
+    X(0xCD, call_nn) \
+    X(0xCE, adc_n) \
+    X(0xCF, rst<0x08>) \
+    X(0xD0, ret_ncc<Registers::Flag::C>) \
+    X(0xD1, pop_rr<Registers::DE>) \
+    X(0xD2, jp_ncc_nn<Registers::Flag::C>) \
+    X(0xD4, call_ncc_nn<Registers::Flag::C>) \
+    X(0xD5, push_rr<Registers::DE>) \
+    X(0xD6, sub_n) \
+    X(0xD7, rst<0x10>) \
+    X(0xD8, ret_cc<Registers::Flag::C>) \
+    X(0xD9, reti) \
+    X(0xDA, jp_cc_nn<Registers::Flag::C>) \
+    X(0xDC, call_cc_nn<Registers::Flag::C>) \
+    X(0xDE, sbc_n) \
+    X(0xDF, rst<0x18>) \
+    X(0xE0, ldh_an_A) \
+    X(0xE1, pop_rr<Registers::HL>) \
+    X(0xE2, ldh_aC_A) \
+    X(0xE5, push_rr<Registers::HL>) \
+    X(0xE6, and_n) \
+    X(0xE7, rst<0x20>) \
+    X(0xE8, add_SP_n) \
+    X(0xE9, jp_HL) \
+    X(0xEA, ld_nn_A) \
+    X(0xEE, xor_n) \
+    X(0xEF, rst<0x28>) \
+    X(0xF0, ldh_A_an) \
+    X(0xF1, pop_rr<Registers::AF>) \
+    X(0xF2, ldh_A_aC) \
+    X(0xF3, di) \
+    X(0xF5, push_rr<Registers::AF>) \
+    X(0xF6, or_n) \
+    X(0xF7, rst<0x30>) \
+    X(0xF8, ld_HL_SP_r8) \
+    X(0xF9, ld_SP_HL) \
+    X(0xFA, ld_A_nn) \
+    X(0xFB, ei) \
+    X(0xFE, cp_n) \
+    X(0xFF, rst<0x38>)
+
+
+#define GB_CB_OPCODES(X) \
+    X(0x00, rlc_r<Registers::B>) \
+    X(0x01, rlc_r<Registers::C>) \
+    X(0x02, rlc_r<Registers::D>) \
+    X(0x03, rlc_r<Registers::E>) \
+    X(0x04, rlc_r<Registers::H>) \
+    X(0x05, rlc_r<Registers::L>) \
+    X(0x06, rlc_HL) \
+    X(0x07, rlc_r<Registers::A>) \
+    X(0x08, rrc_r<Registers::B>) \
+    X(0x09, rrc_r<Registers::C>) \
+    X(0x0A, rrc_r<Registers::D>) \
+    X(0x0B, rrc_r<Registers::E>) \
+    X(0x0C, rrc_r<Registers::H>) \
+    X(0x0D, rrc_r<Registers::L>) \
+    X(0x0E, rrc_HL) \
+    X(0x0F, rrc_r<Registers::A>) \
+    X(0x10, rl_r<Registers::B>) \
+    X(0x11, rl_r<Registers::C>) \
+    X(0x12, rl_r<Registers::D>) \
+    X(0x13, rl_r<Registers::E>) \
+    X(0x14, rl_r<Registers::H>) \
+    X(0x15, rl_r<Registers::L>) \
+    X(0x16, rl_HL) \
+    X(0x17, rl_r<Registers::A>) \
+    X(0x18, rr_r<Registers::B>) \
+    X(0x19, rr_r<Registers::C>) \
+    X(0x1A, rr_r<Registers::D>) \
+    X(0x1B, rr_r<Registers::E>) \
+    X(0x1C, rr_r<Registers::H>) \
+    X(0x1D, rr_r<Registers::L>) \
+    X(0x1E, rr_HL) \
+    X(0x1F, rr_r<Registers::A>) \
+    X(0x20, sla_r<Registers::B>) \
+    X(0x21, sla_r<Registers::C>) \
+    X(0x22, sla_r<Registers::D>) \
+    X(0x23, sla_r<Registers::E>) \
+    X(0x24, sla_r<Registers::H>) \
+    X(0x25, sla_r<Registers::L>) \
+    X(0x26, sla_HL) \
+    X(0x27, sla_r<Registers::A>) \
+    X(0x28, sra_r<Registers::B>) \
+    X(0x29, sra_r<Registers::C>) \
+    X(0x2A, sra_r<Registers::D>) \
+    X(0x2B, sra_r<Registers::E>) \
+    X(0x2C, sra_r<Registers::H>) \
+    X(0x2D, sra_r<Registers::L>) \
+    X(0x2E, sra_HL) \
+    X(0x2F, sra_r<Registers::A>) \
+    X(0x30, swap_r<Registers::B>) \
+    X(0x31, swap_r<Registers::C>) \
+    X(0x32, swap_r<Registers::D>) \
+    X(0x33, swap_r<Registers::E>) \
+    X(0x34, swap_r<Registers::H>) \
+    X(0x35, swap_r<Registers::L>) \
+    X(0x36, swap_HL) \
+    X(0x37, swap_r<Registers::A>) \
+    X(0x38, srl_r<Registers::B>) \
+    X(0x39, srl_r<Registers::C>) \
+    X(0x3A, srl_r<Registers::D>) \
+    X(0x3B, srl_r<Registers::E>) \
+    X(0x3C, srl_r<Registers::H>) \
+    X(0x3D, srl_r<Registers::L>) \
+    X(0x3E, srl_HL) \
+    X(0x3F, srl_r<Registers::A>) \
+    X(0x40, bit_n_r<0, Registers::B>) \
+    X(0x41, bit_n_r<0, Registers::C>) \
+    X(0x42, bit_n_r<0, Registers::D>) \
+    X(0x43, bit_n_r<0, Registers::E>) \
+    X(0x44, bit_n_r<0, Registers::H>) \
+    X(0x45, bit_n_r<0, Registers::L>) \
+    X(0x46, bit_n_HL<0>) \
+    X(0x47, bit_n_r<0, Registers::A>) \
+    X(0x48, bit_n_r<1, Registers::B>) \
+    X(0x49, bit_n_r<1, Registers::C>) \
+    X(0x4A, bit_n_r<1, Registers::D>) \
+    X(0x4B, bit_n_r<1, Registers::E>) \
+    X(0x4C, bit_n_r<1, Registers::H>) \
+    X(0x4D, bit_n_r<1, Registers::L>) \
+    X(0x4E, bit_n_HL<1>) \
+    X(0x4F, bit_n_r<1, Registers::A>) \
+    X(0x50, bit_n_r<2, Registers::B>) \
+    X(0x51, bit_n_r<2, Registers::C>) \
+    X(0x52, bit_n_r<2, Registers::D>) \
+    X(0x53, bit_n_r<2, Registers::E>) \
+    X(0x54, bit_n_r<2, Registers::H>) \
+    X(0x55, bit_n_r<2, Registers::L>) \
+    X(0x56, bit_n_HL<2>) \
+    X(0x57, bit_n_r<2, Registers::A>) \
+    X(0x58, bit_n_r<3, Registers::B>) \
+    X(0x59, bit_n_r<3, Registers::C>) \
+    X(0x5A, bit_n_r<3, Registers::D>) \
+    X(0x5B, bit_n_r<3, Registers::E>) \
+    X(0x5C, bit_n_r<3, Registers::H>) \
+    X(0x5D, bit_n_r<3, Registers::L>) \
+    X(0x5E, bit_n_HL<3>) \
+    X(0x5F, bit_n_r<3, Registers::A>) \
+    X(0x60, bit_n_r<4, Registers::B>) \
+    X(0x61, bit_n_r<4, Registers::C>) \
+    X(0x62, bit_n_r<4, Registers::D>) \
+    X(0x63, bit_n_r<4, Registers::E>) \
+    X(0x64, bit_n_r<4, Registers::H>) \
+    X(0x65, bit_n_r<4, Registers::L>) \
+    X(0x66, bit_n_HL<4>) \
+    X(0x67, bit_n_r<4, Registers::A>) \
+    X(0x68, bit_n_r<5, Registers::B>) \
+    X(0x69, bit_n_r<5, Registers::C>) \
+    X(0x6A, bit_n_r<5, Registers::D>) \
+    X(0x6B, bit_n_r<5, Registers::E>) \
+    X(0x6C, bit_n_r<5, Registers::H>) \
+    X(0x6D, bit_n_r<5, Registers::L>) \
+    X(0x6E, bit_n_HL<5>) \
+    X(0x6F, bit_n_r<5, Registers::A>) \
+    X(0x70, bit_n_r<6, Registers::B>) \
+    X(0x71, bit_n_r<6, Registers::C>) \
+    X(0x72, bit_n_r<6, Registers::D>) \
+    X(0x73, bit_n_r<6, Registers::E>) \
+    X(0x74, bit_n_r<6, Registers::H>) \
+    X(0x75, bit_n_r<6, Registers::L>) \
+    X(0x76, bit_n_HL<6>) \
+    X(0x77, bit_n_r<6, Registers::A>) \
+    X(0x78, bit_n_r<7, Registers::B>) \
+    X(0x79, bit_n_r<7, Registers::C>) \
+    X(0x7A, bit_n_r<7, Registers::D>) \
+    X(0x7B, bit_n_r<7, Registers::E>) \
+    X(0x7C, bit_n_r<7, Registers::H>) \
+    X(0x7D, bit_n_r<7, Registers::L>) \
+    X(0x7E, bit_n_HL<7>) \
+    X(0x7F, bit_n_r<7, Registers::A>) \
+    X(0x80, res_n_r<0, Registers::B>) \
+    X(0x81, res_n_r<0, Registers::C>) \
+    X(0x82, res_n_r<0, Registers::D>) \
+    X(0x83, res_n_r<0, Registers::E>) \
+    X(0x84, res_n_r<0, Registers::H>) \
+    X(0x85, res_n_r<0, Registers::L>) \
+    X(0x86, res_n_HL<0>) \
+    X(0x87, res_n_r<0, Registers::A>) \
+    X(0x88, res_n_r<1, Registers::B>) \
+    X(0x89, res_n_r<1, Registers::C>) \
+    X(0x8A, res_n_r<1, Registers::D>) \
+    X(0x8B, res_n_r<1, Registers::E>) \
+    X(0x8C, res_n_r<1, Registers::H>) \
+    X(0x8D, res_n_r<1, Registers::L>) \
+    X(0x8E, res_n_HL<1>) \
+    X(0x8F, res_n_r<1, Registers::A>) \
+    X(0x90, res_n_r<2, Registers::B>) \
+    X(0x91, res_n_r<2, Registers::C>) \
+    X(0x92, res_n_r<2, Registers::D>) \
+    X(0x93, res_n_r<2, Registers::E>) \
+    X(0x94, res_n_r<2, Registers::H>) \
+    X(0x95, res_n_r<2, Registers::L>) \
+    X(0x96, res_n_HL<2>) \
+    X(0x97, res_n_r<2, Registers::A>) \
+    X(0x98, res_n_r<3, Registers::B>) \
+    X(0x99, res_n_r<3, Registers::C>) \
+    X(0x9A, res_n_r<3, Registers::D>) \
+    X(0x9B, res_n_r<3, Registers::E>) \
+    X(0x9C, res_n_r<3, Registers::H>) \
+    X(0x9D, res_n_r<3, Registers::L>) \
+    X(0x9E, res_n_HL<3>) \
+    X(0x9F, res_n_r<3, Registers::A>) \
+    X(0xA0, res_n_r<4, Registers::B>) \
+    X(0xA1, res_n_r<4, Registers::C>) \
+    X(0xA2, res_n_r<4, Registers::D>) \
+    X(0xA3, res_n_r<4, Registers::E>) \
+    X(0xA4, res_n_r<4, Registers::H>) \
+    X(0xA5, res_n_r<4, Registers::L>) \
+    X(0xA6, res_n_HL<4>) \
+    X(0xA7, res_n_r<4, Registers::A>) \
+    X(0xA8, res_n_r<5, Registers::B>) \
+    X(0xA9, res_n_r<5, Registers::C>) \
+    X(0xAA, res_n_r<5, Registers::D>) \
+    X(0xAB, res_n_r<5, Registers::E>) \
+    X(0xAC, res_n_r<5, Registers::H>) \
+    X(0xAD, res_n_r<5, Registers::L>) \
+    X(0xAE, res_n_HL<5>) \
+    X(0xAF, res_n_r<5, Registers::A>) \
+    X(0xB0, res_n_r<6, Registers::B>) \
+    X(0xB1, res_n_r<6, Registers::C>) \
+    X(0xB2, res_n_r<6, Registers::D>) \
+    X(0xB3, res_n_r<6, Registers::E>) \
+    X(0xB4, res_n_r<6, Registers::H>) \
+    X(0xB5, res_n_r<6, Registers::L>) \
+    X(0xB6, res_n_HL<6>) \
+    X(0xB7, res_n_r<6, Registers::A>) \
+    X(0xB8, res_n_r<7, Registers::B>) \
+    X(0xB9, res_n_r<7, Registers::C>) \
+    X(0xBA, res_n_r<7, Registers::D>) \
+    X(0xBB, res_n_r<7, Registers::E>) \
+    X(0xBC, res_n_r<7, Registers::H>) \
+    X(0xBD, res_n_r<7, Registers::L>) \
+    X(0xBE, res_n_HL<7>) \
+    X(0xBF, res_n_r<7, Registers::A>) \
+    X(0xC0, set_n_r<0, Registers::B>) \
+    X(0xC1, set_n_r<0, Registers::C>) \
+    X(0xC2, set_n_r<0, Registers::D>) \
+    X(0xC3, set_n_r<0, Registers::E>) \
+    X(0xC4, set_n_r<0, Registers::H>) \
+    X(0xC5, set_n_r<0, Registers::L>) \
+    X(0xC6, set_n_HL<0>) \
+    X(0xC7, set_n_r<0, Registers::A>) \
+    X(0xC8, set_n_r<1, Registers::B>) \
+    X(0xC9, set_n_r<1, Registers::C>) \
+    X(0xCA, set_n_r<1, Registers::D>) \
+    X(0xCB, set_n_r<1, Registers::E>) \
+    X(0xCC, set_n_r<1, Registers::H>) \
+    X(0xCD, set_n_r<1, Registers::L>) \
+    X(0xCE, set_n_HL<1>) \
+    X(0xCF, set_n_r<1, Registers::A>) \
+    X(0xD0, set_n_r<2, Registers::B>) \
+    X(0xD1, set_n_r<2, Registers::C>) \
+    X(0xD2, set_n_r<2, Registers::D>) \
+    X(0xD3, set_n_r<2, Registers::E>) \
+    X(0xD4, set_n_r<2, Registers::H>) \
+    X(0xD5, set_n_r<2, Registers::L>) \
+    X(0xD6, set_n_HL<2>) \
+    X(0xD7, set_n_r<2, Registers::A>) \
+    X(0xD8, set_n_r<3, Registers::B>) \
+    X(0xD9, set_n_r<3, Registers::C>) \
+    X(0xDA, set_n_r<3, Registers::D>) \
+    X(0xDB, set_n_r<3, Registers::E>) \
+    X(0xDC, set_n_r<3, Registers::H>) \
+    X(0xDD, set_n_r<3, Registers::L>) \
+    X(0xDE, set_n_HL<3>) \
+    X(0xDF, set_n_r<3, Registers::A>) \
+    X(0xE0, set_n_r<4, Registers::B>) \
+    X(0xE1, set_n_r<4, Registers::C>) \
+    X(0xE2, set_n_r<4, Registers::D>) \
+    X(0xE3, set_n_r<4, Registers::E>) \
+    X(0xE4, set_n_r<4, Registers::H>) \
+    X(0xE5, set_n_r<4, Registers::L>) \
+    X(0xE6, set_n_HL<4>) \
+    X(0xE7, set_n_r<4, Registers::A>) \
+    X(0xE8, set_n_r<5, Registers::B>) \
+    X(0xE9, set_n_r<5, Registers::C>) \
+    X(0xEA, set_n_r<5, Registers::D>) \
+    X(0xEB, set_n_r<5, Registers::E>) \
+    X(0xEC, set_n_r<5, Registers::H>) \
+    X(0xED, set_n_r<5, Registers::L>) \
+    X(0xEE, set_n_HL<5>) \
+    X(0xEF, set_n_r<5, Registers::A>) \
+    X(0xF0, set_n_r<6, Registers::B>) \
+    X(0xF1, set_n_r<6, Registers::C>) \
+    X(0xF2, set_n_r<6, Registers::D>) \
+    X(0xF3, set_n_r<6, Registers::E>) \
+    X(0xF4, set_n_r<6, Registers::H>) \
+    X(0xF5, set_n_r<6, Registers::L>) \
+    X(0xF6, set_n_HL<6>) \
+    X(0xF7, set_n_r<6, Registers::A>) \
+    X(0xF8, set_n_r<7, Registers::B>) \
+    X(0xF9, set_n_r<7, Registers::C>) \
+    X(0xFA, set_n_r<7, Registers::D>) \
+    X(0xFB, set_n_r<7, Registers::E>) \
+    X(0xFC, set_n_r<7, Registers::H>) \
+    X(0xFD, set_n_r<7, Registers::L>) \
+    X(0xFE, set_n_HL<7>) \
+    X(0xFF, set_n_r<7, Registers::A>)
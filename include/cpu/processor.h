@@ -2,6 +2,10 @@
 
 #include "utils/global.h"
 
+#include "block_cache.h"
+#ifdef ANOTHERGB_JIT
+#include "jit.h"
+#endif
 #include "logger.h"
 #include "registery.h"
 
@@ -10,6 +14,11 @@
 
 class Memory;
 
+namespace utils
+{
+class Scheduler;
+}
+
 namespace cpu
 {
 enum class Interrupt
@@ -27,20 +36,85 @@ class Processor
 {
 public:
     using Instruction = int (Processor::*)();
+    using Handler = int (*)(Processor&);
+
+    // Machine cycles in a frame (70224 T-cycles).
+    static constexpr uint64_t cyclesPerFrame = 70224 / 4;
 
     Processor() = delete;
     Processor(Registers& regist, Memory& mem);
 
     void runNextInstruction(bool trace);
+    // Runs the whole decoded block starting at PC, decoding it on first use.
+    // Produces the same state and cycles as calling runNextInstruction for
+    // each of its instructions.
+    void runNextBlock();
+    // Runs blocks for one frame worth of cycles, returns the cycles run.
+    uint64_t runFrame();
+
+    bool isHalted() const
+    {
+        return m_isHalt || m_isStopped;
+    }
 
     void handleInterrupt(Interrupt interruptType);
     std::optional<Interrupt> pendingInterrupt() const;
     void updateClocks(int ticks);
+
+    uint64_t getCycles() const
+    {
+        return m_cycles;
+    }
+
+    // Cycles skipped in idle loops since the processor was created.
+    uint64_t getIdleCyclesSkipped() const
+    {
+        return m_idleCyclesSkipped;
+    }
+
+#ifdef ANOTHERGB_JIT
+    // Hot blocks run as native code when enabled (default).
+    void setJitEnabled(bool enabled)
+    {
+        m_jitEnabled = enabled;
+    }
+
+    size_t getCompiledBlocks() const
+    {
+        return m_jit.compiledBlocks();
+    }
+#endif
 private:
     void fillInstructionSet();
     void fillCbInstructionSet();
+
+    // Switch based dispatch, used instead of the tables when built with
+    // ANOTHERGB_THREADED_DISPATCH.
+    int execute(uint8_t opCode);
+    int executeCb(uint8_t opCode);
+
+    // Plain function wrapper around a handler, used by decoded blocks.
+    template<Instruction handler>
+    static int call(Processor& processor)
+    {
+        return (processor.*handler)();
+    }
+
+    Block& decodeBlock(uint16_t bank, uint16_t pc);
+    // Runs one decoded instruction, also called from native blocks.
+    static int runDecoded(Processor& processor, const DecodedInstruction* decoded);
+#ifdef ANOTHERGB_JIT
+    // Clock sync of native blocks, see Jit::ClockSync.
+    static int syncNative(Processor& processor, int cycles);
+#endif
+    // Machine cycles until the next scheduled event, 0 when it is due.
+    int cyclesUntilNextEvent() const;
     
-    std::optional<int> getTIMANbCycles() const;
+    // Skips the time spent halted, returns false while still halted.
+    bool fastForwardHalt();
+    // Runs the iterations of an idle loop ending before the next event at
+    // once, as they would all read the same values.
+    void skipIdleLoop(int iterationCycles);
     int unhandled();
 
     uint8_t getImmediate8();
@@ -92,24 +166,18 @@ private:
 
     void updateFlags(uint16_t res, bool n, bool h, bool c)
     {
-        m_registers.setFlag(Registers::Flag::Z, res == 0);
-        m_registers.setFlag(Registers::Flag::N, n);
-        m_registers.setFlag(Registers::Flag::H, h);
-        m_registers.setFlag(Registers::Flag::C, c);
+        m_registers.setFlags(res, n, (h ? 0x10 : 0) | (c ? 0x100 : 0));
     }
     // 8-bit arithmetic and logical instructions
     void updateFlagsWithCarry8bit(int carryBits, uint8_t res, bool carryFlag, bool n)
     {
-        bool h = (carryBits & 0x10) == 0x10;
-        bool c = (carryBits & 0x100) == 0x100;
-        
-        m_registers.setFlag(Registers::Flag::Z, res == 0);
-        m_registers.setFlag(Registers::Flag::N, n);
-        m_registers.setFlag(Registers::Flag::H, h);
-        
         if (carryFlag)
         {
-            m_registers.setFlag(Registers::Flag::C, c);
+            m_registers.setFlags(res, n, carryBits);
+        }
+        else
+        {
+            m_registers.setFlagsKeepCarry(res, n, carryBits);
         }
     }
 
@@ -174,12 +242,8 @@ private:
     // 16-bit arithmetic
     void updateFlagsWithCarry16bit(int carryBits, bool carryFlag, bool n)
     {
-        bool h = (carryBits & 0x1000) == 0x1000;
-        bool c = carryFlag && ((carryBits & 0x10000) == 0x10000);
-
-        m_registers.setFlag(Registers::Flag::N, n);
-        m_registers.setFlag(Registers::Flag::H, h);
-        m_registers.setFlag(Registers::Flag::C, c);
+        int carries = (carryBits >> 8) & (carryFlag ? 0x110 : 0x10);
+        m_registers.setFlagsKeepZero(n, carries);
     }
 
     template<Registers::Paired NAME>
@@ -286,12 +350,28 @@ private:
     Logger m_tracer;
     Registers& m_registers;
     Memory& m_memory;
+    utils::Scheduler& m_scheduler;
 
     Instruction m_instructionSet[256];
     Instruction m_cbInstructionSet[256];
-
-    int m_divCycleCounter = 0;
-    int m_timaCycleCounter = 0;
+    Handler m_handlers[256];
+    Handler m_cbHandlers[256];
+
+    BlockCache m_blockCache;
+    // Instruction being run from a decoded block, its immediates are read from
+    // there instead of memory.
+    const DecodedInstruction* m_decoded = nullptr;
+
+#ifdef ANOTHERGB_JIT
+    Jit m_jit;
+    bool m_jitEnabled = true;
+    // Block cache generation when the running native block was entered.
+    uint32_t m_nativeGeneration = 0;
+#endif
+
+    uint64_t m_cycles = 0;
+    uint64_t m_frameEnd = 0;
+    uint64_t m_idleCyclesSkipped = 0;
 
     bool m_IME = false;
     bool m_isHalt = false;
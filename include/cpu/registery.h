@@ -3,6 +3,7 @@
 #include "utils/global.h"
 #include "utils/utils.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <cassert>
 #include <string>
@@ -53,24 +54,67 @@ public:
         Z = 0b1000'0000
     };
 
+    // F is not stored, the last flag setting operation is recorded instead and
+    // Z/N/H/C are computed when read:
+    // - Z is set when the recorded result is 0,
+    // - H and C are bits 4 and 8 of the recorded carry bits (a ^ b ^ result
+    //   for 8-bit arithmetic).
+    void setFlags(uint16_t result, bool n, int carryBits)
+    {
+        m_flagResult = result;
+        m_flagN = n;
+        m_flagCarries = (uint16_t)carryBits;
+    }
+    // Same, C is left unchanged (inc / dec).
+    void setFlagsKeepCarry(uint16_t result, bool n, int carryBits)
+    {
+        m_flagResult = result;
+        m_flagN = n;
+        m_flagCarries = (carryBits & 0x10) | (m_flagCarries & 0x100);
+    }
+    // Same, Z is left unchanged (16-bit arithmetic).
+    void setFlagsKeepZero(bool n, int carryBits)
+    {
+        m_flagN = n;
+        m_flagCarries = (uint16_t)carryBits;
+    }
+
     void setFlag(Flag f, bool enabled = true)
     {
-        if (!enabled)
-        {
-            m_registers[(int)F] &= ~(uint8_t)f;
-        }
-        else
+        switch (f)
         {
-            m_registers[(int)F] |= (uint8_t)f;
+        case Flag::Z:
+            m_flagResult = enabled ? 0 : 1;
+            break;
+        case Flag::N:
+            m_flagN = enabled;
+            break;
+        case Flag::H:
+            m_flagCarries = (m_flagCarries & ~0x10) | (enabled ? 0x10 : 0);
+            break;
+        case Flag::C:
+            m_flagCarries = (m_flagCarries & ~0x100) | (enabled ? 0x100 : 0);
+            break;
         }
     }
-    bool isSetFlag(Flag f)
+    bool isSetFlag(Flag f) const
     {
-        return (m_registers[(int)F] & (uint8_t)f) == (uint8_t)f;
+        switch (f)
+        {
+        case Flag::Z:
+            return m_flagResult == 0;
+        case Flag::N:
+            return m_flagN;
+        case Flag::H:
+            return (m_flagCarries & 0x10) != 0;
+        case Flag::C:
+            return (m_flagCarries & 0x100) != 0;
+        }
+        return false;
     }
     void resetFlags()
     {
-        m_registers[(int)F] = 0;
+        setFlags(1, false, 0);
     }
 
     template<Paired NAME>
@@ -85,20 +129,32 @@ public:
     {
         if constexpr (NAME == Names::F)
         {
-            val = val & 0xF0;
+            m_flagResult = (val & 0x80) ? 0 : 1;
+            m_flagN = (val & 0x40) != 0;
+            m_flagCarries = ((val & 0x20) >> 1) | ((val & 0x10) << 4);
+        }
+        else
+        {
+            m_registers[(int)NAME] = val;
         }
-        m_registers[(int)NAME] = val;
     }
   
     template<Paired NAME>
     uint16_t read16()
     {
-        return utils::to16(m_registers[(int)NAME], m_registers[(int)NAME + 1]);
+        return utils::to16(read8<(Names)((int)NAME)>(), read8<(Names)((int)NAME + 1)>());
     }
 
     template<Names NAME>
     uint8_t read8()
     {
+        if constexpr (NAME == Names::F)
+        {
+            return (m_flagResult == 0 ? 0x80 : 0)
+                | (m_flagN ? 0x40 : 0)
+                | ((m_flagCarries & 0x10) << 1)
+                | ((m_flagCarries & 0x100) >> 4);
+        }
         return m_registers[(int)NAME];
     }
 
@@ -124,6 +180,32 @@ public:
         m_sp = sp;
     }
 
+    // Byte offsets inside Registers, used by generated code.
+    static constexpr size_t offsetOf(Names name)
+    {
+        return offsetof(Registers, m_registers) + (size_t)name;
+    }
+    static constexpr size_t offsetOfFlagResult()
+    {
+        return offsetof(Registers, m_flagResult);
+    }
+    static constexpr size_t offsetOfFlagCarries()
+    {
+        return offsetof(Registers, m_flagCarries);
+    }
+    static constexpr size_t offsetOfFlagN()
+    {
+        return offsetof(Registers, m_flagN);
+    }
+    static constexpr size_t offsetOfSP()
+    {
+        return offsetof(Registers, m_sp);
+    }
+    static constexpr size_t offsetOfPC()
+    {
+        return offsetof(Registers, m_pc);
+    }
+
     template<uint8_t v>
     static constexpr Names opFieldToName()
     {
@@ -204,8 +286,12 @@ public:
         return "";
     }
 private:
-    uint8_t m_registers[8] = {};
+    uint8_t m_registers[8] = {}; // F slot unused
     uint16_t m_sp = 0;
     uint16_t m_pc = 0;
+
+    uint16_t m_flagResult = 1;
+    uint16_t m_flagCarries = 0;
+    bool m_flagN = false;
 };
 }
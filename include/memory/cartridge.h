@@ -1,10 +1,13 @@
 #pragma once
 
 #include "rom.h"
+#include "rom_image.h"
 
 #include <string>
 #include <memory>
 
+class Memory;
+
 class Cartridge
 {
 public:
@@ -17,25 +20,60 @@ public:
 		MBC5
 	};
 
+	// Unreadable files give a blank ROM only cartridge.
 	Cartridge(const char* filePath);
-	uint8_t nbRomBank() const
+	Cartridge(std::shared_ptr<const RomImage> image);
+
+	const std::shared_ptr<const RomImage>& getImage() const
+	{
+		return m_image;
+	}
+
+	uint16_t nbRomBank() const
 	{
 		return m_nbRomBank;
 	}
 
-	uint8_t nbRamBank()
+	uint8_t nbRamBank() const
 	{
 		return m_nbRamBank;
 	}
 
-	static std::unique_ptr<Rom> buildRomFromCartridge(const Cartridge& cartridge);
+	Type getType() const
+	{
+		return m_cartridgeType;
+	}
+
+	bool hasBattery() const
+	{
+		return m_hasBattery;
+	}
+
+	// MBC3 with a real-time clock.
+	bool hasRtc() const
+	{
+		return m_hasRtc;
+	}
+
+	// Next to the ROM file, empty when built from an image.
+	const std::string& getSavePath() const
+	{
+		return m_savePath;
+	}
+
+	// Memory bank controller of the cartridge, mapping its banks into memory.
+	static std::unique_ptr<Rom> buildRomFromCartridge(const Cartridge& cartridge, Memory& memory);
 private:
 
-	void loadCartidge(const char* filePath);
+	void parseHeader();
 
+	std::shared_ptr<const RomImage> m_image;
 	std::string m_title;
+	std::string m_savePath;
+	bool m_hasBattery = false;
+	bool m_hasRtc = false;
 	Type m_cartridgeType = Type::ROM_ONLY;
 
-	uint8_t m_nbRomBank;
-	uint8_t m_nbRamBank;
+	uint16_t m_nbRomBank = 2;
+	uint8_t m_nbRamBank = 0;
 };
\ No newline at end of file
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "rom.h"
+#include "save_file.h"
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Memory;
+
+// Shared by the controllers: external RAM and its enable bit.
+//
+// Battery backed RAM lives in a SaveFile. Its pages are mapped read only
+// until first written, the write then goes through writeRam which marks the
+// page dirty and maps it writable. Dirty pages are flushed every
+// flushPeriod, then mapped read only again.
+class BankedRom : public Rom
+{
+public:
+	// An empty savePath means no battery. trailerSize bytes after the RAM in
+	// the save file are left to the controller.
+	BankedRom(Memory& memory, size_t ramSize, const std::string& savePath = "", size_t trailerSize = 0);
+
+	void writeRam(uint16_t addr, uint8_t val) override;
+
+	static constexpr uint64_t flushPeriod = 60 * 70224; // T-cycles, 60 frames
+
+protected:
+	static constexpr size_t unmapped = (size_t)-1;
+
+	void mapRam(size_t bank);
+	void unmapRam();
+
+	void markDirty(size_t offset);
+
+	// Called before the save file is flushed, to update the trailer.
+	virtual void saveTrailer()
+	{
+	}
+
+	// nullptr without a save file.
+	uint8_t* trailer()
+	{
+		return m_save != nullptr ? m_save->data() + m_ramSize : nullptr;
+	}
+
+	Memory& m_memory;
+	uint8_t* m_ram = nullptr;
+	size_t m_ramSize = 0;
+	bool m_ramEnabled = false;
+
+private:
+	void onFlush(uint64_t timestamp);
+
+	std::vector<uint8_t> m_volatileRam;
+	std::unique_ptr<SaveFile> m_save;
+
+	size_t m_mappedBank = unmapped;
+	// Pages of each bank written since the last flush.
+	std::vector<uint32_t> m_writablePages;
+};
+
+// 32 KiB ROM, optionally with 8 KiB of RAM always mapped.
+class RomOnly : public BankedRom
+{
+public:
+	using BankedRom::BankedRom;
+
+	void reset() override;
+	void write(uint16_t addr, uint8_t val) override;
+};
+
+class Mbc1 : public BankedRom
+{
+public:
+	using BankedRom::BankedRom;
+
+	void reset() override;
+	void write(uint16_t addr, uint8_t val) override;
+
+private:
+	void map();
+
+	uint8_t m_bank1 = 1;     // 5 bits
+	uint8_t m_bank2 = 0;     // 2 bits, upper ROM bits or RAM bank
+	bool m_advancedMode = false;
+};
+
+// 512 x 4 bits of built-in RAM, mirrored over 0xA000-0xBFFF.
+class Mbc2 : public BankedRom
+{
+public:
+	Mbc2(Memory& memory, const std::string& savePath = "");
+
+	void reset() override;
+	void write(uint16_t addr, uint8_t val) override;
+
+	uint8_t readRam(uint16_t addr) override;
+	void writeRam(uint16_t addr, uint8_t val) override;
+};
+
+// The RTC isn't ticked: its time is a base value plus the emulated cycles
+// elapsed since, computed only when latched or written. With a battery it
+// is saved in the 48-byte trailer most emulators append to the RAM dump
+// (current and latched registers as 32-bit words, then a 64-bit UNIX
+// timestamp), and the time spent switched off is added back on load.
+class Mbc3 : public BankedRom
+{
+public:
+	static constexpr size_t rtcTrailerSize = 48;
+
+	Mbc3(Memory& memory, size_t ramSize, const std::string& savePath = "", bool hasRtc = false);
+	~Mbc3() override;
+
+	void reset() override;
+	void write(uint16_t addr, uint8_t val) override;
+
+	// RTC registers, when selected instead of a RAM bank.
+	uint8_t readRam(uint16_t addr) override;
+	void writeRam(uint16_t addr, uint8_t val) override;
+
+private:
+	static constexpr uint64_t secondsPerDay = 24 * 60 * 60;
+	// Days counter is 9 bits.
+	static constexpr uint64_t maxSeconds = 512 * secondsPerDay;
+
+	void mapRam();
+
+	uint64_t rtcSeconds() const;
+	void setRtcSeconds(uint64_t seconds);
+	std::array<uint8_t, 5> rtcRegisters();
+
+	void loadTrailer();
+	void saveTrailer() override;
+
+	uint8_t m_ramBank = 0;   // 0x00-0x03 RAM, 0x08-0x0C RTC
+	uint8_t m_latch = 0xFF;
+	std::array<uint8_t, 5> m_latchedRtc = {};
+
+	bool m_hasRtc = false;
+	uint64_t m_rtcBase = 0;       // Seconds at m_rtcBaseCycle
+	uint64_t m_rtcBaseCycle = 0;
+	bool m_rtcHalted = false;
+	bool m_dayCarry = false;
+};
+
+class Mbc5 : public BankedRom
+{
+public:
+	using BankedRom::BankedRom;
+
+	void reset() override;
+	void write(uint16_t addr, uint8_t val) override;
+
+private:
+	void map();
+
+	uint16_t m_romBank = 1;  // 9 bits, bank 0 can be mapped
+	uint8_t m_ramBank = 0;
+};
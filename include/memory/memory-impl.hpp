@@ -0,0 +1,51 @@
+#pragma once
+
+#include "cpu/block_cache.h"
+
+// Plain ROM / RAM pages are handled here so that the processor handlers
+// inline them, only pages without a pointer call out to the slow path.
+
+inline void Memory::write8(uint16_t addr, uint8_t val)
+{
+    uint8_t* page = m_writePages[addr >> 8];
+    if (page == nullptr) [[unlikely]]
+    {
+        writeSlow(addr, val);
+        return;
+    }
+
+    page[addr & 0xFF] = val;
+    if (addr >= 0xC000 && m_blockCache != nullptr)
+    {
+        m_blockCache->onWrite(addr);
+    }
+}
+
+inline uint8_t Memory::read8(uint16_t addr)
+{
+    const uint8_t* page = m_readPages[addr >> 8];
+    if (page == nullptr) [[unlikely]]
+    {
+        return readSlow(addr);
+    }
+
+    return page[addr & 0xFF];
+}
+
+inline void Memory::write16(uint16_t addr, uint16_t val)
+{
+    write8(addr, utils::low(val));
+    write8(addr + 1, utils::high(val));
+}
+
+inline uint16_t Memory::read16(uint16_t addr)
+{
+    // Both bytes in the same mapped page.
+    const uint8_t* page = m_readPages[addr >> 8];
+    if ((addr & 0xFF) != 0xFF && page != nullptr) [[likely]]
+    {
+        return utils::to16(page[(addr & 0xFF) + 1], page[addr & 0xFF]);
+    }
+
+    return utils::to16(read8(addr + 1), read8(addr));
+}
@@ -4,19 +4,28 @@
 #include "utils/utils.h"
 
 #include "mmio.h"
+#include "rom_image.h"
+#include "timer.h"
+#include "utils/scheduler.h"
 
 #include <fstream>
 #include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
 
 class Cartridge;
 namespace cpu
 {
+class BlockCache;
 class Registers;
 }
 class Rom;
 namespace video
 {
+class ObjectLines;
 class Screen;
+class TileCache;
 }
 
 class Memory
@@ -32,23 +41,143 @@ public:
     FORCEINLINE void write16(uint16_t index, uint16_t val);
     FORCEINLINE uint16_t read16(uint16_t index);
 
+    // Maps another ROM file, the cartridge's one is mapped at construction.
     bool loadROM(const char* filename);
 
-    void disableBootRom()
+    void disableBootRom();
+
+    bool isBootRomEnabled() const
+    {
+        return m_bootROMEnabled;
+    }
+
+    // Bank currently mapped at 0x4000-0x7FFF
+    uint16_t getRomBank() const
+    {
+        return m_romBankNumber;
+    }
+
+    // Bank currently mapped at 0x0000-0x3FFF
+    uint16_t getLowRomBank() const
+    {
+        return m_lowRomBankNumber;
+    }
+
+    // Repoints 0x4000-0x7FFF to another bank of the loaded ROM, wrapping
+    // around its size.
+    void setRomBank(uint16_t bank);
+    // Same for 0x0000-0x3FFF, only MBC1 remaps it.
+    void setLowRomBank(uint16_t bank);
+    // Maps 8 KiB of external RAM at 0xA000-0xBFFF, nullptr unmaps it. Writes
+    // to pages not set in writablePages, and any access while unmapped, go to
+    // the cartridge.
+    void setRamBank(uint8_t* ram, uint32_t writablePages = 0xFFFFFFFF);
+
+    void setBlockCache(cpu::BlockCache* blockCache)
+    {
+        m_blockCache = blockCache;
+    }
+
+    void setTileCache(video::TileCache* tileCache)
+    {
+        m_tileCache = tileCache;
+    }
+
+    void setObjectLines(video::ObjectLines* objectLines)
+    {
+        m_objectLines = objectLines;
+    }
+
+    // Global clock and hardware events.
+    utils::Scheduler& getScheduler()
+    {
+        return m_scheduler;
+    }
+
+    void requestInterrupt(uint8_t bit)
+    {
+        m_memoryMap[0xFF0F] |= 1 << bit;
+    }
+
+    // Clears the IF bit of a serviced interrupt, reachable while DMA holds the
+    // bus.
+    void acknowledgeInterrupt(uint8_t bit)
+    {
+        m_memoryMap[0xFF0F] &= ~(1 << bit);
+    }
+
+    // IF & IE, read without going through MMIO.
+    uint8_t pendingInterrupts() const
+    {
+        return m_memoryMap[0xFF0F] & m_memoryMap[0xFFFF] & 0x1F;
+    }
+
+    bool isDmaActive() const
+    {
+        return m_mmio.isDmaActive();
+    }
+
+    // While OAM DMA runs the CPU only reaches HRAM, other reads return 0xFF
+    // and writes are dropped.
+    void blockBus(bool blocked);
+
+    // Video RAM, OAM and I/O registers as seen by the PPU, which doesn't go
+    // through the CPU bus.
+    const uint8_t* getVideoRam() const
     {
-        m_bootROMEnabled = false;
+        return &m_memoryMap[0x8000];
     }
 
-    void incrementDIV();
+    const uint8_t* getOam() const
+    {
+        return &m_memoryMap[0xFE00];
+    }
+
+    uint8_t& ioRegister(uint16_t addr)
+    {
+        return m_memoryMap[addr];
+    }
 
 private:
     friend MMIO;
 
     bool loadBootROM(const char* filename);
 
+    // Pages without a pointer, see m_readPages.
+    uint8_t readSlow(uint16_t addr);
+    void writeSlow(uint16_t addr, uint8_t val);
+
+    void mapPages(uint16_t addr, uint16_t size, const uint8_t* read, uint8_t* write);
+    void mapRom();
+
+    utils::Scheduler m_scheduler;
+    Timer m_timer;
     MMIO m_mmio;
     std::unique_ptr<Rom> m_romBank;
-    uint8_t m_memoryMap[0x10000];
+    uint8_t m_memoryMap[0x10000] = {};
+    std::shared_ptr<const RomImage> m_rom;
+
+    // One entry per 256 byte page, pointing to the start of the page. Plain
+    // ROM and RAM accesses are a single indexed load. A null entry is the
+    // handler bit: the access goes through readSlow / writeSlow (I/O
+    // registers, cartridge registers, echo RAM, tile data and OAM writes).
+    std::array<const uint8_t*, 256> m_readPages = {};
+    std::array<uint8_t*, 256> m_writePages = {};
+
+    // Mapping to restore once the bus is released, the tables above are all
+    // null meanwhile. Bank switches done during DMA land here.
+    std::array<const uint8_t*, 256> m_heldReadPages = {};
+    std::array<uint8_t*, 256> m_heldWritePages = {};
+    bool m_busBlocked = false;
+
     uint8_t* m_bootROM = nullptr;
     bool m_bootROMEnabled = true;
-};
\ No newline at end of file
+    uint16_t m_romBankNumber = 1;
+    uint16_t m_lowRomBankNumber = 0;
+
+    cpu::BlockCache* m_blockCache = nullptr;
+    video::TileCache* m_tileCache = nullptr;
+    video::ObjectLines* m_objectLines = nullptr;
+};
+
+#include "memory-impl.hpp"
@@ -23,17 +23,37 @@ public:
 	uint8_t read(uint16_t addr) const;
 	void write(uint16_t addr, uint8_t val);
 
-	void incrementTIMA(uint16_t addr, uint8_t val);
 	void disableBootROM(uint16_t addr, uint8_t val);
 
+	// Scheduled event handlers
+	void onDmaEnd();
+	void onSerialEnd();
+
+	bool isDmaActive() const
+	{
+		return m_dmaActive;
+	}
+
 private:
 	uint8_t readAddress(uint16_t addr) const;
 
 	// Read-only address
 	void empty(uint16_t, uint8_t);
 
+	void serialControl(uint16_t addr, uint8_t val);
+
 	void resetDIV(uint16_t addr, uint8_t val);
+	void writeTIMA(uint16_t addr, uint8_t val);
+	void writeTMA(uint16_t addr, uint8_t val);
+	void writeTAC(uint16_t addr, uint8_t val);
+	uint8_t readDIV(uint16_t addr) const;
+	uint8_t readTIMA(uint16_t addr) const;
+	uint8_t readTMA(uint16_t addr) const;
+	uint8_t readTAC(uint16_t addr) const;
+
 	void lcdControl(uint16_t addr, uint8_t val);
+	void writeSTAT(uint16_t addr, uint8_t val);
+	uint8_t readSTAT(uint16_t addr) const;
 	void scy(uint16_t addr, uint8_t val);
 	void scx(uint16_t addr, uint8_t val);
 	void lyc(uint16_t addr, uint8_t val);
@@ -55,4 +75,6 @@ private:
 	mapped_ioR m_mappedIOsR[128];
 
 	cpu::Registers& m_registers;
+
+	bool m_dmaActive = false;
 };
\ No newline at end of file
@@ -2,10 +2,27 @@
 
 #include <cstdint>
 
+// Cartridge memory bank controller.
+//
+// ROM and RAM banks are mapped straight into the memory page table, bank
+// select writes only repoint them. The controller itself only sees writes to
+// its registers (0x0000-0x7FFF) and accesses to 0xA000-0xBFFF while no RAM
+// bank is mapped there.
 class Rom
 {
 public:
-	virtual ~Rom() = 0;
-	virtual uint8_t read(uint16_t addr) = 0;
+	virtual ~Rom() = default;
+
+	// Maps the banks selected at power on.
+	virtual void reset() = 0;
 	virtual void write(uint16_t addr, uint8_t val) = 0;
-};
\ No newline at end of file
+
+	virtual uint8_t readRam(uint16_t /*addr*/)
+	{
+		return 0xFF;
+	}
+
+	virtual void writeRam(uint16_t /*addr*/, uint8_t /*val*/)
+	{
+	}
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Read-only image of a ROM file, shared by every emulator instance running it.
+//
+// The file is mapped in memory rather than read, so loading costs no copy and
+// instances of the same ROM share its pages. Files that aren't a whole number
+// of 16 KiB banks (at least two) are copied into a padded buffer instead, as
+// banks are mapped past their end. A mapped file must not be truncated while
+// still in use.
+class RomImage
+{
+public:
+	// Returns the image already mapped for this file if it didn't change
+	// since, nullptr when the file can't be read.
+	static std::shared_ptr<const RomImage> open(const char* filePath);
+	// Two empty banks, used when no ROM is loaded.
+	static std::shared_ptr<const RomImage> blank();
+
+	~RomImage();
+
+	RomImage(const RomImage&) = delete;
+	RomImage& operator=(const RomImage&) = delete;
+
+	const uint8_t* data() const
+	{
+		return m_data;
+	}
+
+	size_t size() const
+	{
+		return m_size;
+	}
+
+	size_t nbBanks() const
+	{
+		return m_size / 0x4000;
+	}
+
+	// Whether the pages are mapped from the file rather than copied.
+	bool isMapped() const
+	{
+		return m_mapping != nullptr;
+	}
+
+private:
+	RomImage() = default;
+
+	bool map(const char* filePath);
+	void copy(const uint8_t* data, size_t size);
+
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+
+	void* m_mapping = nullptr;
+	size_t m_mappingSize = 0;
+	std::vector<uint8_t> m_copy;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Battery backed cartridge RAM, mapped from its .sav file.
+//
+// The file is a raw dump of the RAM banks, like most emulators write it.
+// Longer files (an RTC footer after the RAM) are kept as is. The emulation
+// thread writes straight into the mapping and marks the pages it changed. A
+// background thread syncs those pages to disk when asked, and everything is
+// synced on destruction.
+//
+// A file has a single owner, locked for as long as it is mapped. Other
+// instances running the same game, in this process or another, get a copy of
+// the file that is never saved instead of writing into the owner's RAM.
+class SaveFile
+{
+public:
+	// Falls back to plain memory, never saved, when the file can't be mapped
+	// or is already owned. The memory starts as a copy of the file.
+	SaveFile(const std::string& path, size_t size);
+	~SaveFile();
+
+	SaveFile(const SaveFile&) = delete;
+	SaveFile& operator=(const SaveFile&) = delete;
+
+	uint8_t* data()
+	{
+		return m_data;
+	}
+
+	size_t size() const
+	{
+		return m_size;
+	}
+
+	bool isMapped() const
+	{
+		return m_mapping != nullptr;
+	}
+
+	void markDirty(size_t offset)
+	{
+		m_dirty[offset / pageSize] = true;
+	}
+
+	// Hands the dirty pages to the flush thread, doesn't wait for it.
+	void flushAsync();
+	// Syncs every dirty page before returning.
+	void flush();
+
+	// Granularity of the dirty tracking, the memory page size.
+	static constexpr size_t pageSize = 0x100;
+
+private:
+	bool map(const std::string& path);
+	void unmap();
+	void loadCopy(const std::string& path);
+
+	void run();
+	void sync(const std::vector<bool>& pages);
+
+	uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+
+	void* m_mapping = nullptr;
+	size_t m_mappingSize = 0;
+	// Kept open while mapped, it holds the ownership lock.
+#ifdef _WIN32
+	void* m_file = nullptr;
+#else
+	int m_fd = -1;
+#endif
+	std::vector<uint8_t> m_fallback;
+
+	// Only touched by the emulation thread.
+	std::vector<bool> m_dirty;
+
+	std::mutex m_mutex;
+	std::condition_variable m_wakeUp;
+	std::condition_variable m_synced;
+	std::vector<bool> m_pending;
+	bool m_hasPending = false;
+	bool m_syncing = false;
+	bool m_stop = false;
+	std::thread m_thread;
+};
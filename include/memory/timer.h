@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+
+class Memory;
+namespace utils
+{
+class Scheduler;
+}
+
+// DIV and TIMA are computed from the global clock when read instead of being
+// incremented, only TIMA overflows are scheduled.
+class Timer
+{
+public:
+    Timer(Memory& memory, utils::Scheduler& scheduler);
+
+    uint8_t readDIV() const;
+    void resetDIV();
+
+    uint8_t readTIMA() const;
+    void writeTIMA(uint8_t val);
+
+    uint8_t readTMA() const
+    {
+        return m_tma;
+    }
+    void writeTMA(uint8_t val)
+    {
+        m_tma = val;
+    }
+
+    uint8_t readTAC() const
+    {
+        return m_tac;
+    }
+    void writeTAC(uint8_t val);
+
+private:
+    bool isEnabled() const
+    {
+        return (m_tac & 0x04) != 0;
+    }
+
+    // T-cycles between two TIMA increments.
+    uint64_t period() const;
+    // TIMA increments since the last DIV reset, at the given time.
+    uint64_t ticksAt(uint64_t time) const;
+
+    // Stores the current TIMA before its rate or origin changes.
+    void snapshot();
+    void scheduleOverflow();
+    void onOverflow(uint64_t timestamp);
+
+    Memory& m_memory;
+    utils::Scheduler& m_scheduler;
+
+    uint64_t m_divReset = 0;
+
+    // TIMA value at m_timaTime
+    uint8_t m_tima = 0;
+    uint64_t m_timaTime = 0;
+
+    uint8_t m_tma = 0;
+    uint8_t m_tac = 0;
+};
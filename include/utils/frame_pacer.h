@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace utils
+{
+
+// Keeps emulation in step with the host clock, one frame at a time.
+//
+// The host clock is sampled once per frame: the pacer sleeps until the
+// emulated time of the frame has elapsed. A speed of 0 disables throttling
+// entirely, which is what batch runs want.
+class FramePacer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // T-cycles per second and per frame of the DMG.
+    static constexpr uint64_t clockFrequency = 4'194'304;
+    static constexpr uint64_t cyclesPerFrame = 70'224;
+
+    static constexpr double unthrottled = 0.0;
+
+    explicit FramePacer(double speed = 1.0);
+
+    // Multiple of real-time speed, or unthrottled.
+    void setSpeed(double speed);
+
+    double getSpeed() const
+    {
+        return m_speed;
+    }
+
+    // Called after each emulated frame of the given T-cycles, sleeps for the
+    // remaining time of the frame.
+    void endFrame(uint64_t cycles = cyclesPerFrame);
+
+    // Emulated time over host time during the last second, 1.0 is real-time.
+    double getMeasuredSpeed() const
+    {
+        return m_measuredSpeed;
+    }
+
+private:
+    // Past this lag, the pacer stops trying to catch up.
+    static constexpr std::chrono::milliseconds maxLag{ 100 };
+
+    void resync(Clock::time_point now);
+
+    double m_speed;
+    Clock::time_point m_deadline;
+
+    Clock::time_point m_windowStart;
+    uint64_t m_windowCycles = 0;
+    double m_measuredSpeed = 0.0;
+};
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+
+namespace utils
+{
+
+// Hardware events, at most one of each kind is pending at a time.
+enum class Event : uint8_t
+{
+    Timer,     // TIMA overflow
+    PPU,       // Next PPU mode change
+    DMA,       // End of OAM DMA
+    Serial,    // End of a serial transfer
+    SaveFlush  // Periodic sync of battery backed RAM
+};
+constexpr size_t eventCount = 5;
+
+// Global clock in T-cycles and the events scheduled on it, kept in an
+// indexed min-heap. The CPU only advances the clock, events run once their
+// timestamp is reached.
+class Scheduler
+{
+public:
+    // Gets the timestamp the event was scheduled at, which may be slightly in
+    // the past.
+    using Handler = std::function<void(uint64_t timestamp)>;
+
+    static constexpr uint64_t never = std::numeric_limits<uint64_t>::max();
+
+    Scheduler();
+
+    uint64_t now() const
+    {
+        return m_now;
+    }
+
+    uint64_t nextTimestamp() const
+    {
+        return m_next;
+    }
+
+    void advance(uint64_t cycles)
+    {
+        m_now += cycles;
+        if (m_now >= m_next)
+        {
+            runDue();
+        }
+    }
+
+    void setHandler(Event event, Handler handler);
+
+    // Reschedules the event if already pending.
+    void schedule(Event event, uint64_t timestamp);
+    void cancel(Event event);
+
+    bool isScheduled(Event event) const
+    {
+        return m_positions[(size_t)event] >= 0;
+    }
+
+private:
+    void runDue();
+
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    void swap(size_t a, size_t b);
+    void remove(size_t index);
+
+    uint64_t timestampAt(size_t index) const
+    {
+        return m_timestamps[(size_t)m_heap[index]];
+    }
+
+    uint64_t m_now = 0;
+    uint64_t m_next = never;
+
+    std::array<Event, eventCount> m_heap = {};
+    size_t m_size = 0;
+
+    std::array<uint64_t, eventCount> m_timestamps = {};
+    std::array<int, eventCount> m_positions = {};
+    std::array<Handler, eventCount> m_handlers;
+};
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+
+namespace video
+{
+// Triple buffer handing finished frames from the emulation thread to one
+// consumer thread. Neither side ever waits: the producer swaps its back
+// buffer with the middle one, the consumer swaps its front buffer with the
+// middle one when it holds a newer frame.
+class FrameExchange
+{
+public:
+	static constexpr size_t maxLines = 256;
+	using LineSet = std::bitset<maxLines>;
+
+	explicit FrameExchange(size_t frameSize);
+
+	// Producer side, the buffer being rendered.
+	uint8_t* getBackBuffer()
+	{
+		return m_buffers[m_back].get();
+	}
+
+	// 0, 1 or 2, tells which buffer the back buffer is.
+	int getBackIndex() const
+	{
+		return m_back;
+	}
+
+	// Lines of the back buffer that differ from the previously published
+	// frame, filled by the producer before publishing.
+	LineSet& getBackChangedLines()
+	{
+		return m_changedLines[m_back];
+	}
+
+	// Hands the back buffer over as the latest frame, returns the buffer to
+	// render next.
+	uint8_t* publish();
+
+	// Consumer side, true when a frame was published since the last acquire.
+	bool hasNewFrame() const
+	{
+		return (m_middle.load(std::memory_order_relaxed) & newFrameBit) != 0;
+	}
+
+	// Latest published frame, valid until the next acquire. Blank until the
+	// first frame is published.
+	const uint8_t* acquire();
+
+	// Number (from 1) and changed lines of the frame returned by the last
+	// acquire. When the number isn't the previous one + 1 frames were
+	// missed, so the changed lines don't cover everything since.
+	uint64_t getFrontNumber() const
+	{
+		return m_numbers[m_front];
+	}
+
+	const LineSet& getFrontChangedLines() const
+	{
+		return m_changedLines[m_front];
+	}
+
+	// Number of frames published so far.
+	uint64_t getPublishedFrames() const
+	{
+		return m_published.load(std::memory_order_relaxed);
+	}
+
+private:
+	static constexpr uint8_t indexMask = 0x03;
+	static constexpr uint8_t newFrameBit = 0x04;
+
+	std::unique_ptr<uint8_t[]> m_buffers[3];
+	uint64_t m_numbers[3] = {};
+	LineSet m_changedLines[3];
+
+	uint8_t m_back = 0;
+	uint8_t m_front = 1;
+	// Index of the middle buffer, plus newFrameBit while the consumer hasn't
+	// taken it.
+	std::atomic<uint8_t> m_middle = 2;
+	std::atomic<uint64_t> m_published = 0;
+};
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+namespace video
+{
+// Objects covering each screen line, kept up to date as OAM is written so
+// that drawing a line doesn't scan the 40 entries.
+class ObjectLines
+{
+public:
+	static constexpr int nbObjects = 40;
+	static constexpr int maxObjectsPerLine = 10;
+	static constexpr int nbLines = 144;
+
+	void setOam(const uint8_t* oam);
+	// 8 or 16
+	void setObjectHeight(uint8_t height);
+
+	// Called after every write to 0xFE00-0xFE9F, only Y moves an object
+	// between lines.
+	void onWrite(uint16_t addr)
+	{
+		if ((addr & 0x03) == 0)
+		{
+			move((addr - 0xFE00) >> 2);
+		}
+	}
+
+	// Called after OAM is rewritten at once (DMA).
+	void rebuild();
+
+	// Objects drawn on the line: the first 10 in OAM order, sorted by
+	// drawing priority (lower X first, then OAM order). Returns their count.
+	int select(uint8_t line, uint8_t (&objects)[maxObjectsPerLine]) const;
+
+private:
+	void move(int object);
+	void setLines(int object, bool covered);
+
+	const uint8_t* m_oam = nullptr;
+	uint8_t m_height = 8;
+
+	// Bit i set when object i covers the line.
+	uint64_t m_lineMasks[nbLines] = {};
+	// Top line of each object as last recorded in m_lineMasks.
+	int m_tops[nbObjects] = {};
+};
+}
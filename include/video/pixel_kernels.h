@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace video
+{
+// The PPU's per-pixel loops. x86-64 builds also have SSE2 and AVX2 versions,
+// best() picks the fastest one the host supports.
+struct PixelKernels
+{
+	const char* name;
+
+	// 16 bytes of 2bpp tile data to 64 color ids, one per byte, leftmost
+	// pixel of the top row first.
+	void (*decodeTile)(const uint8_t* data, uint8_t* colorIds);
+
+	// Both take count pixel indices, a multiple of 32, each below 16.
+	// lookup writes lut[index] per pixel.
+	void (*lookup)(const uint8_t* indices, const uint8_t* lut, uint8_t* out, int count);
+	// toRgba writes the color whose gray level is lut[index].
+	void (*toRgba)(const uint8_t* indices, const uint8_t* lut, uint8_t* rgba, int count);
+
+	static const PixelKernels& best();
+
+	// Every set this host can run, scalar first.
+	static std::vector<const PixelKernels*> available();
+};
+}
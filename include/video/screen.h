@@ -1,5 +1,9 @@
 #pragma once
 
+#include "frame_exchange.h"
+#include "object_lines.h"
+#include "tile_cache.h"
+
 #include <cstdint>
 
 class Memory;
@@ -7,7 +11,7 @@ class Memory;
 namespace video
 {
 constexpr uint8_t SCREEN_WIDTH = 160;
-constexpr uint8_t SCREEN_HEIGHT = 140;
+constexpr uint8_t SCREEN_HEIGHT = 144;
 
 class Screen
 {
@@ -16,11 +20,42 @@ public:
 	Screen();
 	~Screen();
 
-	void tick(uint8_t count);
-
+	// Also starts the PPU, which then runs on the memory's scheduler.
 	void setMemory(Memory* memory);
 
-	uint8_t* getFrameBuffer();
+	enum class PixelFormat
+	{
+		Shade8,  // As rendered, one byte per pixel from 0 (white) to 3 (black)
+		Gray8,   // One byte per pixel, 255 white
+		Rgba8888
+	};
+
+	// Frame being rendered, only for the emulation thread. One shade per
+	// pixel, 0 (white) to 3 (black), SCREEN_WIDTH pixels per line.
+	const uint8_t* getFrameBuffer() const;
+
+	// Which frames are drawn, LY / STAT timing and interrupts don't change.
+	// 1 draws every frame, N every Nth one and 0 none (headless). Skipped
+	// frames aren't published and leave the frame buffer as it was. Both
+	// take effect from the next frame.
+	void setRenderInterval(uint32_t interval);
+	// Draws that frame whatever the interval, e.g. the last one before a
+	// snapshot.
+	void requestFrame(uint64_t frame);
+	// Frames completed so far, the one being drawn has this number.
+	uint64_t getFrameCount() const;
+	// Lines actually drawn, the others already were in the frame buffer.
+	uint64_t getDrawnLines() const;
+
+	// Frames completed at VBlank, for a presentation thread.
+	FrameExchange& getFrames()
+	{
+		return m_frames;
+	}
+
+	// Converts a frame of shades, dst holds SCREEN_WIDTH * SCREEN_HEIGHT
+	// pixels of the format.
+	static void convertFrame(const uint8_t* frame, PixelFormat format, uint8_t* dst);
 
 	void setSCY(uint8_t scy);
 	void setSCX(uint8_t scx);
@@ -30,6 +65,11 @@ public:
 	uint8_t getLY() const;
 	void setLYC(uint8_t lyc);
 
+	// Mode and LY=LYC bits are computed from the PPU state when read, only
+	// the interrupt enables (bits 3-6) are stored.
+	uint8_t getSTAT() const;
+	void setSTAT(uint8_t stat);
+
 	void enableLCD(bool enabled);
 	void enableWindow(bool enabled);
 	void enableObj(bool enabled);
@@ -44,24 +84,69 @@ public:
 
 private:
 
-	void updateStatusRegister();
-
+	void startLCD(uint64_t now);
+	// Scheduled at every mode change.
+	void onModeEnd(uint64_t timestamp);
+	void enterMode(uint8_t mode);
+	// Decides if the frame starting is drawn.
+	void startFrame();
+	// Called whenever a STAT interrupt source may have changed.
+	void updateStatInterrupt();
+
+	// Composes the layers of a line in m_lineIds then writes it to the frame
+	// buffer, unless the buffer already holds that line.
+	void renderLine(uint8_t line);
+	// Hash of everything the line's pixels depend on.
+	uint64_t lineFingerprint(uint8_t line);
+	// Fills m_lineObjects, in drawing priority order.
+	void selectObjects(uint8_t line);
 	void renderBG(uint8_t line);
-	void renderWindow(uint8_t line);
+	// Draws line m_windowLine of the window over the background.
+	void renderWindow();
+	// Number of background pixels left of the window.
+	int backgroundWidth() const;
 	void renderObjects(uint8_t line);
 
-	uint64_t getTileLine(uint16_t tileAddr, uint8_t line);
-	uint16_t fromTileIdtoAdress(uint8_t tileId);
-	uint8_t fromColorIdtoColor(uint8_t colorId);
+	// Decodes count tiles of a tile map row, starting at firstTile, 8 color
+	// ids per tile.
+	void drawTileRow(uint8_t* dst, uint16_t tileMapRow, uint8_t firstTile, uint8_t tileY, int count);
+
+	// Index in the tile cache of a background / window tile id.
+	uint16_t fromTileIdtoIndex(uint8_t tileId);
+	static uint8_t fromColorIdtoColor(uint8_t shade);
+	static uint8_t applyPalette(uint8_t palette, uint8_t colorId);
 
 private:
-	Memory* m_memory;
+	Memory* m_memory = nullptr;
 
 	uint16_t m_windowTileMapAddr = 0x9800;
-	uint16_t m_tileDataArea = 0x8800;
+	uint16_t m_tileDataArea = 0x8000;
 	uint16_t m_bgTileMapAddr = 0x9800;
 	
+	FrameExchange m_frames;
+	// Back buffer of m_frames
 	uint8_t* m_frameBuffer = nullptr;
+
+	TileCache m_tileCache;
+	ObjectLines m_objectLines;
+
+	const PixelKernels& m_kernels;
+
+	// Background and window color ids of the line being rendered, pixel x is
+	// at x + 8 so that partially visible tiles are written whole. Objects
+	// then write their color id + 4 (OBP0) or + 8 (OBP1).
+	uint8_t m_lineIds[SCREEN_WIDTH + 16] = {};
+	// Shade of each m_lineIds value through the palettes.
+	uint8_t m_lineShades[16] = {};
+
+	uint8_t m_lineObjects[ObjectLines::maxObjectsPerLine] = {};
+	int m_nbLineObjects = 0;
+
+	// Fingerprints of the last drawn frame, and of the lines each buffer of
+	// m_frames holds (0 when never drawn).
+	uint64_t m_lineFingerprints[SCREEN_HEIGHT] = {};
+	uint64_t m_bufferFingerprints[3][SCREEN_HEIGHT] = {};
+	uint64_t m_drawnLines = 0;
 	
 	uint8_t m_ObjectSize = 8;
 	
@@ -72,14 +157,29 @@ private:
 	uint8_t m_scx = 0;
 	uint8_t m_wy = 0;
 	uint8_t m_wx = 0;
+	// Window line drawn on the current line, counts only the lines where the
+	// window showed since the start of the frame.
+	uint8_t m_windowLine = 0;
+	bool m_windowTriggered = false;
+	bool m_windowVisible = false;
 	
 	uint8_t m_bgPalette = 0;
 
-	uint16_t m_scanlineCounter = 0;
+	uint8_t m_mode = 0;
+
+	uint32_t m_renderInterval = 1;
+	uint64_t m_requestedFrame = UINT64_MAX;
+	uint64_t m_frameCount = 0;
+	bool m_renderFrame = true;
+	uint8_t m_statEnable = 0;
+	bool m_statLine = false;
+	// Timestamp of the start of the current line.
+	uint64_t m_lineStart = 0;
 
+	// LCDC as left by the boot ROM (0x91).
 	bool m_objectEnable = false;
-	bool m_bgAndWindowPriority = false;
+	bool m_bgAndWindowPriority = true;
 	bool m_lcdEnabled = true;
-	bool m_windowEnabled = true;
+	bool m_windowEnabled = false;
 };
 }
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "pixel_kernels.h"
+
+#include <bitset>
+#include <cassert>
+#include <cstdint>
+
+namespace video
+{
+// The 384 tiles of 0x8000-0x97FF decoded to one color id per byte. Writes to
+// tile data only mark the tile dirty, it is decoded again the next time one
+// of its rows is drawn.
+class TileCache
+{
+public:
+	static constexpr int nbTiles = 384;
+
+	TileCache();
+
+	void setVideoRam(const uint8_t* videoRam);
+
+	// Called for every write to 0x8000-0x97FF.
+	void onWrite(uint16_t addr)
+	{
+		uint16_t tile = (addr - 0x8000) >> 4;
+		m_dirty.set(tile);
+		m_versions[tile]++;
+	}
+
+	// Incremented at every write to the tile's data.
+	uint32_t getVersion(uint16_t tile) const
+	{
+		return m_versions[tile];
+	}
+
+	// 8 color ids, leftmost pixel first.
+	const uint8_t* getRow(uint16_t tile, uint8_t y)
+	{
+		assert(y < 8);
+		if (m_dirty[tile])
+		{
+			decode(tile);
+		}
+		return &m_tiles[tile][y * 8];
+	}
+
+private:
+	void decode(uint16_t tile);
+
+	const PixelKernels& m_kernels;
+	const uint8_t* m_videoRam = nullptr;
+	uint8_t m_tiles[nbTiles][64] = {};
+	std::bitset<nbTiles> m_dirty;
+	uint32_t m_versions[nbTiles] = {};
+};
+}
@@ -1,30 +1,177 @@
-#include <iostream>
-#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
-#include "utils/utils.h"
-
-#include "cpu/executor.h"
+#include "cpu/processor.h"
 #include "cpu/registery.h"
+#include "memory/cartridge.h"
 #include "memory/memory.h"
+#include "utils/frame_pacer.h"
+#include "video/screen.h"
+
+namespace
+{
+void printUsage(const char* program)
+{
+    fprintf(stderr,
+        "usage: %s <rom> [--boot <boot rom>] [--speed <multiplier>] [--unthrottled] [--frames <count>]\n"
+        "          [--headless] [--render-every <n>] [--screenshot <file.pgm>]\n"
+        "  --speed         run at a multiple of real-time speed (default 1)\n"
+        "  --unthrottled   run as fast as the host allows\n"
+        "  --frames        stop after this many frames\n"
+        "  --headless      don't draw frames\n"
+        "  --render-every  only draw one frame out of n\n"
+        "  --screenshot    save the frame following the last one, drawn even when headless\n",
+        program);
+}
+
+bool writeScreenshot(const char* path, const uint8_t* frame)
+{
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    uint8_t gray[video::SCREEN_WIDTH * video::SCREEN_HEIGHT];
+    video::Screen::convertFrame(frame, video::Screen::PixelFormat::Gray8, gray);
+    fprintf(file, "P5\n%d %d\n255\n", video::SCREEN_WIDTH, video::SCREEN_HEIGHT);
+    bool written = fwrite(gray, sizeof(gray), 1, file) == 1;
+
+    return fclose(file) == 0 && written;
+}
+}
 
 int main(int argc, char* argv[])
 {
-    auto fileName = argv[0];
+    if (argc < 2)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    const char* romPath = argv[1];
+    const char* bootRomPath = "";
+    double speed = 1.0;
+    uint64_t maxFrames = 0;
+    uint32_t renderInterval = 1;
+    const char* screenshotPath = nullptr;
+    for (int i = 2; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--boot") == 0 && hasValue)
+        {
+            bootRomPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--speed") == 0 && hasValue)
+        {
+            speed = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--unthrottled") == 0)
+        {
+            speed = utils::FramePacer::unthrottled;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && hasValue)
+        {
+            maxFrames = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--headless") == 0)
+        {
+            renderInterval = 0;
+        }
+        else if (strcmp(argv[i], "--render-every") == 0 && hasValue)
+        {
+            renderInterval = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--screenshot") == 0 && hasValue)
+        {
+            screenshotPath = argv[++i];
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    Cartridge cartridge(romPath);
+    cpu::Registers registers;
+    video::Screen screen;
+    Memory memory(cartridge, registers, screen, bootRomPath);
+    if (!memory.loadROM(romPath))
+    {
+        fprintf(stderr, "Can't load %s\n", romPath);
+        return 1;
+    }
+    screen.setMemory(&memory);
+
+    cpu::Processor processor(registers, memory);
+    if (*bootRomPath == '\0')
+    {
+        memory.disableBootRom();
+        registers.setPC(0x100);
+        registers.setSP(0xFFFE);
+    }
 
-    Memory memory;
-    if (!memory.loadROM(fileName))
+    if (screenshotPath != nullptr && maxFrames == 0)
     {
-        return 0;
+        fprintf(stderr, "--screenshot needs --frames\n");
+        return 1;
     }
 
-    cpu::Registers registery;
-    cpu::Executor instructions(registery, memory);
+    screen.setRenderInterval(renderInterval);
 
-    while (1)
+    // The screenshot is the frame the PPU starts after the last of maxFrames.
+    // The PPU doesn't count frames while the LCD is off, so the run goes on
+    // until that frame is drawn, for at most screenshotTimeout frames.
+    constexpr uint64_t screenshotTimeout = 600;
+    uint64_t screenshotFrame = 0;
+    auto running = [&](uint64_t frame) {
+        if (maxFrames == 0 || frame < maxFrames)
+        {
+            return true;
+        }
+        return screenshotPath != nullptr && screen.getFrameCount() <= screenshotFrame
+            && frame < maxFrames + screenshotTimeout;
+    };
+
+    utils::FramePacer pacer(speed);
+    double lastReported = 0.0;
+    for (uint64_t frame = 0; running(frame); frame++)
     {
-        uint8_t opcode = memory.read8(registery.getPC());
-        instructions.execute<true>(opcode);
+        if (screenshotPath != nullptr && frame + 1 == maxFrames)
+        {
+            screenshotFrame = screen.getFrameCount() + 1;
+            screen.requestFrame(screenshotFrame);
+        }
+
+        uint64_t cycles = processor.runFrame();
+        pacer.endFrame(cycles * 4);
+
+        if (pacer.getMeasuredSpeed() != lastReported)
+        {
+            lastReported = pacer.getMeasuredSpeed();
+            fprintf(stderr, "speed: %.2fx (%.1f fps)\n", lastReported,
+                lastReported * utils::FramePacer::clockFrequency / utils::FramePacer::cyclesPerFrame);
+        }
     }
 
-    return 1;
-}
\ No newline at end of file
+    if (screenshotPath != nullptr)
+    {
+        if (!screen.getFrames().hasNewFrame())
+        {
+            fprintf(stderr, "No frame drawn for %s, the LCD stayed off\n", screenshotPath);
+            return 1;
+        }
+        if (!writeScreenshot(screenshotPath, screen.getFrames().acquire()))
+        {
+            fprintf(stderr, "Can't write %s\n", screenshotPath);
+            return 1;
+        }
+    }
+
+    fprintf(stderr, "idle cycles skipped: %llu of %llu\n",
+        (unsigned long long)processor.getIdleCyclesSkipped(), (unsigned long long)processor.getCycles());
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "block_cache.h"
+
+namespace cpu
+{
+    Block* BlockCache::find(uint16_t bank, uint16_t pc)
+    {
+        m_retired.clear();
+
+        if (isRam(pc))
+        {
+            auto it = m_ramBlocks.find(pc);
+            return it != m_ramBlocks.end() ? it->second.get() : nullptr;
+        }
+
+        auto it = m_romBlocks.find(key(bank, pc));
+        return it != m_romBlocks.end() ? it->second.get() : nullptr;
+    }
+
+    Block& BlockCache::insert(uint16_t bank, Block&& block)
+    {
+        auto ptr = std::make_unique<Block>(std::move(block));
+        Block& inserted = *ptr;
+
+        if (isRam(inserted.startPC))
+        {
+            // Blocks are shorter than a page, they span two pages at most.
+            m_codePages.set(inserted.startPC >> 8);
+            m_codePages.set((inserted.endPC - 1) >> 8);
+
+            m_ramBlocks[inserted.startPC] = std::move(ptr);
+        }
+        else
+        {
+            m_romBlocks[key(bank, inserted.startPC)] = std::move(ptr);
+        }
+
+        return inserted;
+    }
+
+    void BlockCache::clear()
+    {
+        for (auto& [pc, block] : m_romBlocks)
+        {
+            m_retired.push_back(std::move(block));
+        }
+        for (auto& [pc, block] : m_ramBlocks)
+        {
+            m_retired.push_back(std::move(block));
+        }
+        m_romBlocks.clear();
+        m_ramBlocks.clear();
+        m_codePages.reset();
+        m_generation++;
+    }
+
+    void BlockCache::invalidate(uint16_t addr)
+    {
+        m_codePages.reset();
+        for (auto it = m_ramBlocks.begin(); it != m_ramBlocks.end();)
+        {
+            Block& block = *it->second;
+            if (addr >= block.startPC && addr < block.endPC)
+            {
+                m_retired.push_back(std::move(it->second));
+                it = m_ramBlocks.erase(it);
+                m_generation++;
+                continue;
+            }
+
+            // Rebuild the page set from the blocks still alive.
+            m_codePages.set(block.startPC >> 8);
+            m_codePages.set((block.endPC - 1) >> 8);
+            ++it;
+        }
+    }
+}
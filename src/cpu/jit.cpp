@@ -0,0 +1,829 @@
+#include "jit.h"
+
+#include "registery.h"
+
+#include <sys/mman.h>
+
+#include <cstring>
+#include <initializer_list>
+#include <optional>
+#include <vector>
+
+namespace cpu
+{
+namespace
+{
+    constexpr size_t codeSize = 4 * 1024 * 1024;
+
+    // Host registers, x86-64 encoding numbers.
+    enum Host : uint8_t
+    {
+        RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+        R8 = 8, R9 = 9, R10 = 10, R11 = 11, R12 = 12, R13 = 13, R14 = 14, R15 = 15
+    };
+
+    // SM83 register held by each host register while a block runs. The lazy
+    // flag state of Registers lives in r9w (result), di (carry bits) and dl
+    // (N). rbx points to Registers, r12 to Processor and ebp accumulates
+    // cycles. [rsp] holds the cycles after which the block has to leave, when
+    // the next scheduled event is due.
+    constexpr uint8_t hostOf(Registers::Names name)
+    {
+        switch (name)
+        {
+        case Registers::Names::A: return R8;
+        case Registers::Names::F: return RAX; // Not held
+        case Registers::Names::B: return R10;
+        case Registers::Names::C: return R11;
+        case Registers::Names::D: return R13;
+        case Registers::Names::E: return R14;
+        case Registers::Names::H: return R15;
+        case Registers::Names::L: return RSI;
+        }
+        return RAX;
+    }
+
+    constexpr Registers::Names allRegisters[] = {
+        Registers::A, Registers::B, Registers::C,
+        Registers::D, Registers::E, Registers::H, Registers::L
+    };
+
+    // Register encoded in the 3 bit fields of an opcode, (HL) excluded.
+    std::optional<Registers::Names> fieldToName(uint8_t field)
+    {
+        constexpr Registers::Names names[] = {
+            Registers::B, Registers::C, Registers::D, Registers::E,
+            Registers::H, Registers::L, Registers::A, Registers::A
+        };
+        if (field == 6)
+        {
+            return std::nullopt;
+        }
+        return names[field];
+    }
+
+    std::optional<Registers::Paired> pairFromOpCode(uint8_t opCode)
+    {
+        switch (opCode >> 4)
+        {
+        case 0: return Registers::BC;
+        case 1: return Registers::DE;
+        case 2: return Registers::HL;
+        default: return std::nullopt; // SP
+        }
+    }
+
+    // x86 ALU operations, as the /digit of the 0x80 group. The register form
+    // opcode is digit << 3.
+    enum class Alu : uint8_t
+    {
+        Add = 0, Or = 1, Adc = 2, Sbb = 3, And = 4, Sub = 5, Xor = 6, Cmp = 7
+    };
+
+    std::optional<Alu> aluFromOpCode(uint8_t opCode)
+    {
+        switch ((opCode >> 3) & 0x07)
+        {
+        case 0: return Alu::Add;
+        case 2: return Alu::Sub;
+        case 4: return Alu::And;
+        case 5: return Alu::Xor;
+        case 6: return Alu::Or;
+        case 7: return Alu::Cmp;
+        default: return std::nullopt; // adc, sbc
+        }
+    }
+
+    class Emitter
+    {
+    public:
+        void byte(uint8_t b)
+        {
+            m_code.push_back(b);
+        }
+
+        void bytes(std::initializer_list<uint8_t> list)
+        {
+            m_code.insert(m_code.end(), list);
+        }
+
+        void imm16(uint16_t v)
+        {
+            byte(v & 0xFF);
+            byte(v >> 8);
+        }
+
+        void imm32(uint32_t v)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                byte((v >> (8 * i)) & 0xFF);
+            }
+        }
+
+        void imm64(uint64_t v)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                byte((v >> (8 * i)) & 0xFF);
+            }
+        }
+
+        // Byte operations always carry a REX prefix so that sil and r8b-r15b
+        // are addressable.
+        static uint8_t rex(uint8_t reg, uint8_t rm)
+        {
+            return 0x40 | ((reg >> 3) << 2) | (rm >> 3);
+        }
+
+        static uint8_t modrm(uint8_t mod, uint8_t reg, uint8_t rm)
+        {
+            return (mod << 6) | ((reg & 7) << 3) | (rm & 7);
+        }
+
+        void movRR8(uint8_t dst, uint8_t src)
+        {
+            bytes({ rex(src, dst), 0x88, modrm(3, src, dst) });
+        }
+
+        void movRI8(uint8_t dst, uint8_t imm)
+        {
+            bytes({ rex(0, dst), (uint8_t)(0xB0 + (dst & 7)), imm });
+        }
+
+        void aluRR8(Alu op, uint8_t dst, uint8_t src)
+        {
+            bytes({ rex(src, dst), (uint8_t)((uint8_t)op << 3), modrm(3, src, dst) });
+        }
+
+        void aluRI8(Alu op, uint8_t dst, uint8_t imm)
+        {
+            bytes({ rex(0, dst), 0x80, modrm(3, (uint8_t)op, dst), imm });
+        }
+
+        void incR8(uint8_t dst)
+        {
+            bytes({ rex(0, dst), 0xFE, modrm(3, 0, dst) });
+        }
+
+        void decR8(uint8_t dst)
+        {
+            bytes({ rex(0, dst), 0xFE, modrm(3, 1, dst) });
+        }
+
+        // mov byte [rbx + disp], reg / mov reg, byte [rbx + disp]
+        void storeR8(uint8_t disp, uint8_t src)
+        {
+            bytes({ rex(src, RBX), 0x88, modrm(1, src, RBX), disp });
+        }
+
+        void loadR8(uint8_t dst, uint8_t disp)
+        {
+            bytes({ rex(dst, RBX), 0x8A, modrm(1, dst, RBX), disp });
+        }
+
+        // mov word [rbx + disp], imm
+        void storeI16(uint8_t disp, uint16_t imm)
+        {
+            bytes({ 0x66, 0xC7, modrm(1, 0, RBX), disp });
+            imm16(imm);
+        }
+
+        // inc / dec word [rbx + disp]
+        void incM16(uint8_t disp)
+        {
+            bytes({ 0x66, 0xFF, modrm(1, 0, RBX), disp });
+        }
+
+        void decM16(uint8_t disp)
+        {
+            bytes({ 0x66, 0xFF, modrm(1, 1, RBX), disp });
+        }
+
+        void addCycles(uint8_t cycles)
+        {
+            bytes({ 0x83, modrm(3, 0, RBP), cycles }); // add ebp, imm8
+        }
+
+        // mov word [rbx + disp], reg / mov reg, word [rbx + disp]
+        void storeR16(uint8_t disp, uint8_t src)
+        {
+            byte(0x66);
+            if (src >= 8)
+            {
+                byte(rex(src, RBX));
+            }
+            bytes({ 0x89, modrm(1, src, RBX), disp });
+        }
+
+        void loadR16(uint8_t dst, uint8_t disp)
+        {
+            byte(0x66);
+            if (dst >= 8)
+            {
+                byte(rex(dst, RBX));
+            }
+            bytes({ 0x8B, modrm(1, dst, RBX), disp });
+        }
+
+        // Records the ZF of the last operation as the flag result, 0 when Z.
+        void zeroFlag()
+        {
+            bytes({ 0x0F, 0x95, 0xC0 });        // setnz al
+            bytes({ 0x44, 0x0F, 0xB6, 0xC8 });  // movzx r9d, al
+        }
+
+        void nFlag(bool n)
+        {
+            bytes({ 0xB2, (uint8_t)(n ? 1 : 0) }); // mov dl, n
+        }
+
+        // Flags of add, sub and cp: AF and CF become bits 4 and 8 of the
+        // carry bits.
+        void arithmeticFlags(bool n)
+        {
+            bytes({ 0x9F });                    // lahf
+            zeroFlag();
+            bytes({ 0x0F, 0xB6, 0xFC });        // movzx edi, ah
+            bytes({ 0x89, 0xF9 });              // mov ecx, edi
+            bytes({ 0x83, 0xE7, 0x10 });        // and edi, AF
+            bytes({ 0x83, 0xE1, 0x01 });        // and ecx, CF
+            bytes({ 0xC1, 0xE1, 0x08 });        // shl ecx, 8
+            bytes({ 0x09, 0xCF });              // or edi, ecx
+            nFlag(n);
+        }
+
+        // Flags of inc and dec, C is left untouched.
+        void incDecFlags(bool n)
+        {
+            bytes({ 0x9F });                    // lahf
+            zeroFlag();
+            bytes({ 0x0F, 0xB6, 0xCC });        // movzx ecx, ah
+            bytes({ 0x83, 0xE1, 0x10 });        // and ecx, AF
+            bytes({ 0x81, 0xE7 });              // and edi, C
+            imm32(0x100);
+            bytes({ 0x09, 0xCF });              // or edi, ecx
+            nFlag(n);
+        }
+
+        // Flags of and, or and xor: Z from the result, H set for and only.
+        void logicFlags(bool h)
+        {
+            zeroFlag();
+            bytes({ 0xBF });                    // mov edi, h
+            imm32(h ? 0x10 : 0);
+            nFlag(false);
+        }
+
+        // Tests a flag and jumps over `skip` bytes when it doesn't match
+        // `ifSet`.
+        void branchOnFlag(Registers::Flag flag, bool ifSet, uint8_t skip)
+        {
+            if (flag == Registers::Flag::Z)
+            {
+                bytes({ 0x66, 0x45, 0x85, 0xC9 });  // test r9w, r9w
+                bytes({ (uint8_t)(ifSet ? 0x75 : 0x74), skip }); // jnz / jz
+            }
+            else
+            {
+                bytes({ 0xF7, 0xC7 });              // test edi, C
+                imm32(0x100);
+                bytes({ (uint8_t)(ifSet ? 0x74 : 0x75), skip }); // jz / jnz
+            }
+        }
+
+        void prologue()
+        {
+            bytes({ 0x53, 0x55, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57 }); // push rbx, rbp, r12-r15
+            bytes({ 0x48, 0x83, 0xEC, 0x08 });  // sub rsp, 8
+            bytes({ 0x89, 0x14, 0x24 });        // mov [rsp], edx
+            bytes({ 0x49, 0x89, 0xFC });        // mov r12, rdi
+            bytes({ 0x48, 0x89, 0xF3 });        // mov rbx, rsi
+            bytes({ 0x31, 0xED });              // xor ebp, ebp
+        }
+
+        void epilogue()
+        {
+            bytes({ 0x89, 0xE8 });              // mov eax, ebp
+            bytes({ 0x48, 0x83, 0xC4, 0x08 });  // add rsp, 8
+            bytes({ 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5D, 0x5B }); // pop r15-r12, rbp, rbx
+            bytes({ 0xC3 });                    // ret
+        }
+
+        // [rsp] = sync(processor, ebp), ebp = 0
+        void syncClocks(Jit::ClockSync sync)
+        {
+            bytes({ 0x4C, 0x89, 0xE7 });        // mov rdi, r12
+            bytes({ 0x89, 0xEE });              // mov esi, ebp
+            bytes({ 0x48, 0xB8 });              // movabs rax, sync
+            imm64((uint64_t)sync);
+            bytes({ 0xFF, 0xD0 });              // call rax
+            bytes({ 0x89, 0x04, 0x24 });        // mov [rsp], eax
+            bytes({ 0x31, 0xED });              // xor ebp, ebp
+        }
+
+        // Jumps with a rel32 to be patched, returns the offset of the rel32.
+        size_t jumpIfDue()
+        {
+            bytes({ 0x3B, 0x2C, 0x24 });        // cmp ebp, [rsp]
+            bytes({ 0x0F, 0x8D });              // jge
+            return rel32();
+        }
+
+        // Right after syncClocks, when the block has to leave at once.
+        size_t jumpIfSyncedDue()
+        {
+            bytes({ 0x85, 0xC0 });              // test eax, eax
+            bytes({ 0x0F, 0x8E });              // jle
+            return rel32();
+        }
+
+        size_t jump()
+        {
+            byte(0xE9);                         // jmp
+            return rel32();
+        }
+
+        void patch(size_t rel, size_t target)
+        {
+            int32_t offset = (int32_t)(target - (rel + 4));
+            std::memcpy(&m_code[rel], &offset, sizeof(offset));
+        }
+
+        size_t position() const
+        {
+            return m_code.size();
+        }
+
+        // add ebp, fallback(processor, decoded)
+        void callFallback(Jit::Fallback fallback, const DecodedInstruction* decoded)
+        {
+            bytes({ 0x4C, 0x89, 0xE7 });        // mov rdi, r12
+            bytes({ 0x48, 0xBE });              // movabs rsi, decoded
+            imm64((uint64_t)decoded);
+            bytes({ 0x48, 0xB8 });              // movabs rax, fallback
+            imm64((uint64_t)fallback);
+            bytes({ 0xFF, 0xD0 });              // call rax
+            bytes({ 0x01, 0xC5 });              // add ebp, eax
+        }
+
+        const std::vector<uint8_t>& code() const
+        {
+            return m_code;
+        }
+
+    private:
+        size_t rel32()
+        {
+            size_t rel = m_code.size();
+            imm32(0);
+            return rel;
+        }
+
+        std::vector<uint8_t> m_code;
+    };
+
+    bool isIoAddress(uint16_t addr)
+    {
+        return addr >= 0xFF00 && (addr < 0xFF80 || addr == 0xFFFF);
+    }
+
+    // Instructions going through the bus, I/O registers included when the
+    // address comes from a register.
+    bool accessesMemory(uint16_t opCode)
+    {
+        if (opCode > 0xFF)
+        {
+            return (opCode & 0x07) == 6; // (hl)
+        }
+
+        switch (opCode)
+        {
+        case 0x02: case 0x0A: case 0x12: case 0x1A:  // ld (bc) / (de)
+        case 0x22: case 0x2A: case 0x32: case 0x3A:  // ld (hl+) / (hl-)
+        case 0x34: case 0x35: case 0x36:             // inc / dec / ld (hl)
+        case 0x08: case 0xEA: case 0xFA:             // ld (nn)
+        case 0xE0: case 0xF0: case 0xE2: case 0xF2:  // ldh
+        case 0xC9: case 0xD9: case 0xCD:             // ret, reti, call
+            return true;
+        default:
+            break;
+        }
+
+        if (opCode >= 0x40 && opCode < 0xC0 && opCode != 0x76)
+        {
+            return (opCode & 0x07) == 6 || (opCode >= 0x70 && opCode < 0x78);
+        }
+
+        // Stack accesses: ret cc, pop, call cc, push and rst.
+        if (opCode >= 0xC0)
+        {
+            uint8_t low = opCode & 0x0F;
+            return (opCode < 0xE0 && (low == 0x00 || low == 0x08 || low == 0x04 || low == 0x0C))
+                || low == 0x01 || low == 0x05 || low == 0x07 || low == 0x0F;
+        }
+
+        return false;
+    }
+
+    class Translator
+    {
+    public:
+        Translator(Emitter& emitter) :
+            m_emitter(emitter)
+        {}
+
+        void load()
+        {
+            if (!m_loaded)
+            {
+                for (Registers::Names name : allRegisters)
+                {
+                    m_emitter.loadR8(hostOf(name), Registers::offsetOf(name));
+                }
+                m_emitter.loadR16(R9, Registers::offsetOfFlagResult());
+                m_emitter.loadR16(RDI, Registers::offsetOfFlagCarries());
+                m_emitter.loadR8(RDX, Registers::offsetOfFlagN());
+                m_loaded = true;
+            }
+        }
+
+        void spill()
+        {
+            if (m_loaded)
+            {
+                store();
+                m_loaded = false;
+            }
+        }
+
+        // Writes the host registers back, they stay loaded.
+        void store()
+        {
+            for (Registers::Names name : allRegisters)
+            {
+                m_emitter.storeR8(Registers::offsetOf(name), hostOf(name));
+            }
+            m_emitter.storeR16(Registers::offsetOfFlagResult(), R9);
+            m_emitter.storeR16(Registers::offsetOfFlagCarries(), RDI);
+            m_emitter.storeR8(Registers::offsetOfFlagN(), RDX);
+        }
+
+        bool isLoaded() const
+        {
+            return m_loaded;
+        }
+
+        // Emits the native version of the instruction, returns false when it
+        // has to go through its handler.
+        bool translate(const DecodedInstruction& decoded)
+        {
+            if (decoded.opCode > 0xFF)
+            {
+                return false;
+            }
+
+            uint8_t opCode = (uint8_t)decoded.opCode;
+            uint8_t imm = decoded.operand & 0xFF;
+
+            if (opCode == 0x00) // nop
+            {
+                m_emitter.addCycles(1);
+                return true;
+            }
+
+            if (opCode >= 0x40 && opCode < 0x80) // ld r, r
+            {
+                auto dst = fieldToName((opCode >> 3) & 0x07);
+                auto src = fieldToName(opCode & 0x07);
+                if (!dst || !src)
+                {
+                    return false;
+                }
+                load();
+                m_emitter.movRR8(hostOf(*dst), hostOf(*src));
+                m_emitter.addCycles(1);
+                return true;
+            }
+
+            if (opCode >= 0x80 && opCode < 0xC0) // alu A, r
+            {
+                auto op = aluFromOpCode(opCode);
+                auto src = fieldToName(opCode & 0x07);
+                if (!op || !src)
+                {
+                    return false;
+                }
+                load();
+                m_emitter.aluRR8(*op, hostOf(Registers::A), hostOf(*src));
+                aluFlags(*op);
+                m_emitter.addCycles(1);
+                return true;
+            }
+
+            if ((opCode & 0xC7) == 0xC6) // alu A, n
+            {
+                auto op = aluFromOpCode(opCode);
+                if (!op)
+                {
+                    return false;
+                }
+                load();
+                m_emitter.aluRI8(*op, hostOf(Registers::A), imm);
+                aluFlags(*op);
+                m_emitter.addCycles(2);
+                return true;
+            }
+
+            if (opCode < 0x40)
+            {
+                return translateLow(opCode, decoded.operand);
+            }
+
+            return false;
+        }
+
+        // Last instruction of the block, sets PC. Returns false when it has
+        // to go through its handler.
+        bool translateExit(const DecodedInstruction& decoded)
+        {
+            uint16_t next = decoded.nextPC;
+            uint16_t target;
+            int taken;
+            int notTaken;
+            switch (decoded.opCode)
+            {
+            case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // jr
+                target = next + (int8_t)(decoded.operand & 0xFF);
+                taken = 3;
+                notTaken = 2;
+                break;
+            case 0xC3: case 0xC2: case 0xCA: case 0xD2: case 0xDA: // jp
+                target = decoded.operand;
+                taken = 4;
+                notTaken = 3;
+                break;
+            default:
+                if (!translate(decoded))
+                {
+                    return false;
+                }
+                m_emitter.storeI16(Registers::offsetOfPC(), next);
+                return true;
+            }
+
+            if (decoded.opCode == 0x18 || decoded.opCode == 0xC3)
+            {
+                m_emitter.storeI16(Registers::offsetOfPC(), target);
+                m_emitter.addCycles(taken);
+                return true;
+            }
+
+            Registers::Flag flag = (decoded.opCode & 0x10) ? Registers::Flag::C : Registers::Flag::Z;
+            bool ifSet = (decoded.opCode & 0x08) != 0;
+
+            load();
+            m_emitter.storeI16(Registers::offsetOfPC(), next);
+            m_emitter.addCycles(notTaken);
+            // Skips the 6 byte store and the 3 byte add below.
+            m_emitter.branchOnFlag(flag, ifSet, 9);
+            m_emitter.storeI16(Registers::offsetOfPC(), target);
+            m_emitter.addCycles(taken - notTaken);
+            return true;
+        }
+
+    private:
+        void aluFlags(Alu op)
+        {
+            switch (op)
+            {
+            case Alu::And:
+                m_emitter.logicFlags(true);
+                break;
+            case Alu::Or:
+            case Alu::Xor:
+                m_emitter.logicFlags(false);
+                break;
+            default:
+                m_emitter.arithmeticFlags(op != Alu::Add);
+                break;
+            }
+        }
+
+        bool translateLow(uint8_t opCode, uint16_t operand)
+        {
+            uint8_t column = opCode & 0x0F;
+            auto pair = pairFromOpCode(opCode);
+
+            if (column == 0x01) // ld rr, nn
+            {
+                if (pair)
+                {
+                    load();
+                    m_emitter.movRI8(hostOf((Registers::Names)pair.value()), operand >> 8);
+                    m_emitter.movRI8(hostOf((Registers::Names)((int)pair.value() + 1)), operand & 0xFF);
+                }
+                else
+                {
+                    m_emitter.storeI16(Registers::offsetOfSP(), operand);
+                }
+                m_emitter.addCycles(3);
+                return true;
+            }
+
+            if (column == 0x03 || column == 0x0B) // inc rr / dec rr
+            {
+                bool inc = column == 0x03;
+                if (pair)
+                {
+                    load();
+                    uint8_t high = hostOf((Registers::Names)pair.value());
+                    uint8_t low = hostOf((Registers::Names)((int)pair.value() + 1));
+                    m_emitter.aluRI8(inc ? Alu::Add : Alu::Sub, low, 1);
+                    m_emitter.aluRI8(inc ? Alu::Adc : Alu::Sbb, high, 0);
+                }
+                else if (inc)
+                {
+                    m_emitter.incM16(Registers::offsetOfSP());
+                }
+                else
+                {
+                    m_emitter.decM16(Registers::offsetOfSP());
+                }
+                m_emitter.addCycles(2);
+                return true;
+            }
+
+            auto name = fieldToName((opCode >> 3) & 0x07);
+            if (!name)
+            {
+                return false;
+            }
+
+            switch (opCode & 0x07)
+            {
+            case 0x04: // inc r
+                load();
+                m_emitter.incR8(hostOf(*name));
+                m_emitter.incDecFlags(false);
+                m_emitter.addCycles(1);
+                return true;
+            case 0x05: // dec r
+                load();
+                m_emitter.decR8(hostOf(*name));
+                m_emitter.incDecFlags(true);
+                m_emitter.addCycles(1);
+                return true;
+            case 0x06: // ld r, n
+                load();
+                m_emitter.movRI8(hostOf(*name), operand & 0xFF);
+                m_emitter.addCycles(2);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        Emitter& m_emitter;
+        bool m_loaded = false;
+    };
+}
+
+    Jit::Jit()
+    {
+        void* code = mmap(nullptr, codeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (code != MAP_FAILED)
+        {
+            m_code = static_cast<uint8_t*>(code);
+            mprotect(m_code, codeSize, PROT_READ | PROT_EXEC);
+        }
+    }
+
+    Jit::~Jit()
+    {
+        if (m_code != nullptr)
+        {
+            munmap(m_code, codeSize);
+        }
+    }
+
+    bool Jit::isTranslatable(const Block& block)
+    {
+        // RAM code may be rewritten while it runs.
+        if (block.startPC >= 0x8000)
+        {
+            return false;
+        }
+
+        // Accesses to I/O registers with a constant address are frequent
+        // enough to keep on the interpreter, see accessesMemory for the others.
+        for (const DecodedInstruction& decoded : block.instructions)
+        {
+            switch (decoded.opCode)
+            {
+            case 0xE0: case 0xF0: case 0xE2: case 0xF2: // ldh
+                return false;
+            case 0xEA: case 0xFA: case 0x08:            // ld (nn)
+                if (isIoAddress(decoded.operand))
+                {
+                    return false;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        return !block.instructions.empty();
+    }
+
+    Jit::NativeBlock Jit::compile(const Block& block, Fallback fallback, ClockSync sync)
+    {
+        if (m_code == nullptr || !isTranslatable(block))
+        {
+            return nullptr;
+        }
+
+        Emitter emitter;
+        Translator translator(emitter);
+
+        // The block leaves between two instructions when the next event is
+        // due, or when a handler made an interrupt pending or switched banks,
+        // where the interpreter would service it.
+        struct EarlyExit
+        {
+            size_t jump;
+            bool loaded;
+            uint16_t pc;
+        };
+        std::vector<EarlyExit> earlyExits;
+        std::vector<size_t> epilogueJumps;
+
+        emitter.prologue();
+        for (size_t i = 0; i < block.instructions.size(); i++)
+        {
+            const DecodedInstruction& decoded = block.instructions[i];
+            bool last = i + 1 == block.instructions.size();
+
+            if (last ? translator.translateExit(decoded) : translator.translate(decoded))
+            {
+                if (!last)
+                {
+                    earlyExits.push_back({ emitter.jumpIfDue(), translator.isLoaded(), decoded.nextPC });
+                }
+                continue;
+            }
+
+            // The handler sets PC itself. Memory accesses see the clocks at the
+            // start of the instruction, as when running the decoded block.
+            translator.spill();
+            if (accessesMemory(decoded.opCode))
+            {
+                emitter.syncClocks(sync);
+            }
+            emitter.callFallback(fallback, &decoded);
+            if (!last)
+            {
+                emitter.syncClocks(sync);
+                epilogueJumps.push_back(emitter.jumpIfSyncedDue());
+            }
+        }
+        translator.spill();
+
+        size_t epilogue = emitter.position();
+        emitter.epilogue();
+        for (size_t jump : epilogueJumps)
+        {
+            emitter.patch(jump, epilogue);
+        }
+
+        // Out of line so that the common path only runs a compare.
+        for (const EarlyExit& exit : earlyExits)
+        {
+            emitter.patch(exit.jump, emitter.position());
+            if (exit.loaded)
+            {
+                translator.store();
+            }
+            emitter.storeI16(Registers::offsetOfPC(), exit.pc);
+            emitter.patch(emitter.jump(), epilogue);
+        }
+
+        const std::vector<uint8_t>& code = emitter.code();
+        if (m_codeUsed + code.size() > codeSize)
+        {
+            return nullptr;
+        }
+
+        uint8_t* entry = m_code + m_codeUsed;
+        mprotect(m_code, codeSize, PROT_READ | PROT_WRITE);
+        std::memcpy(entry, code.data(), code.size());
+        mprotect(m_code, codeSize, PROT_READ | PROT_EXEC);
+
+        // Keep entries 16 byte aligned.
+        m_codeUsed = (m_codeUsed + code.size() + 15) & ~(size_t)15;
+        m_compiledBlocks++;
+
+        return reinterpret_cast<NativeBlock>(entry);
+    }
+}
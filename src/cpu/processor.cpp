@@ -1,38 +1,36 @@
 #include "processor.h"
+#include "opcodes.h"
 
 #include "memory.h"
 #include "registery.h"
+#include "utils/scheduler.h"
 
+#include <algorithm>
 #include <utility>
 #include <limits>
 #include <iostream>
-#include <chrono>
-#include <thread>
 
 namespace cpu
 {
-    constexpr size_t cpu_frequency = 4'194'304; // Hz
-    constexpr size_t DIV_frequency = 16'384; // Hz
-    constexpr std::chrono::nanoseconds cycle_duration = std::chrono::nanoseconds(1'000'000'000 / cpu_frequency);
-
-    template<int frequency>
-    constexpr int number_of_cycle()
-    {
-        return  cpu_frequency / frequency;
-    }
-
     Processor::Processor(Registers& regist, Memory& mem): 
         m_tracer(regist, mem),
         m_registers(regist), 
-        m_memory(mem)
+        m_memory(mem),
+        m_scheduler(mem.getScheduler())
     {
         fillInstructionSet();
         fillCbInstructionSet();
+
+        m_memory.setBlockCache(&m_blockCache);
     }
     
     void Processor::runNextInstruction(bool trace)
     {
-        auto start = std::chrono::system_clock::now();
+        if (isHalted() && !fastForwardHalt())
+        {
+            return;
+        }
+
         std::optional<Interrupt> interrupt = pendingInterrupt();
         if (m_IME && interrupt.has_value())
         {
@@ -47,37 +45,316 @@ namespace cpu
         }
 
         m_registers.incrementPC();
+#ifdef ANOTHERGB_THREADED_DISPATCH
+        int numberOfCycles = execute(opCode);
+#else
         int numberOfCycles = (this->*m_instructionSet[opCode])();
+#endif
         updateClocks(numberOfCycles);
+    }
 
-        auto end = std::chrono::system_clock::now();
+    uint64_t Processor::runFrame()
+    {
+        uint64_t start = m_cycles;
 
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-        auto waitTime = std::max((duration - cycle_duration*numberOfCycles).count(), 0ll);
-        //std::this_thread::sleep_for(std::chrono::microseconds(waitTime));
+        // The overshoot of a frame is taken from the next one, unless the
+        // processor was run outside of runFrame in between.
+        if (m_frameEnd + cyclesPerFrame <= m_cycles)
+        {
+            m_frameEnd = m_cycles;
+        }
+        m_frameEnd += cyclesPerFrame;
+
+        while (m_cycles < m_frameEnd)
+        {
+            runNextBlock();
+        }
+
+        return m_cycles - start;
     }
 
-    std::optional<int> Processor::getTIMANbCycles() const
+    void Processor::runNextBlock()
     {
-        uint8_t tac_flag = m_memory.read8(0xFF07);
-        if (tac_flag & 0x04)
+        if (isHalted() && !fastForwardHalt())
         {
-            return std::nullopt;
+            return;
+        }
+
+        std::optional<Interrupt> interrupt = pendingInterrupt();
+        if (m_IME && interrupt.has_value())
+        {
+            handleInterrupt(interrupt.value());
         }
 
-        switch (tac_flag & 0x03)
+        uint16_t pc = m_registers.getPC();
+        if (!BlockCache::isCacheable(pc) || (pc <= 0xFF && m_memory.isBootRomEnabled()))
         {
-        case 0x00:
-            return cpu_frequency / 1024;
-        case 0x01:
-            return cpu_frequency / 16;
-        case 0x02:
-            return cpu_frequency / 64;
-        case 0x03:
-            return cpu_frequency / 256;
+            runNextInstruction(false);
+            return;
         }
 
-        return std::nullopt;
+        uint16_t bank = pc < 0x4000 ? m_memory.getLowRomBank() : m_memory.getRomBank();
+        Block* block = m_blockCache.find(bank, pc);
+        if (block == nullptr)
+        {
+            block = &decodeBlock(bank, pc);
+        }
+
+        if (block->instructions.empty())
+        {
+            // First instruction straddles two regions.
+            runNextInstruction(false);
+            return;
+        }
+
+#ifdef ANOTHERGB_JIT
+        if (m_jitEnabled && block->native == nullptr && !block->untranslatable && !block->idleLoop
+            && ++block->executionCount >= Jit::hotThreshold)
+        {
+            block->native = m_jit.compile(*block, &Processor::runDecoded, &Processor::syncNative);
+            block->untranslatable = block->native == nullptr;
+        }
+
+        if (m_jitEnabled && block->native != nullptr)
+        {
+            // Returns the cycles run since the last clock sync. The block
+            // leaves where an interrupt has to be serviced.
+            m_nativeGeneration = m_blockCache.generation();
+            int numberOfCycles = block->native(this, &m_registers, cyclesUntilNextEvent());
+            m_decoded = nullptr;
+            updateClocks(numberOfCycles);
+            return;
+        }
+#endif
+
+        uint32_t generation = m_blockCache.generation();
+        uint64_t nextEvent = m_scheduler.nextTimestamp();
+        int blockCycles = 0;
+        bool completed = true;
+        for (const DecodedInstruction& decoded : block->instructions)
+        {
+            int numberOfCycles = runDecoded(*this, &decoded);
+            updateClocks(numberOfCycles);
+            blockCycles += numberOfCycles;
+
+            // Stop on self modifying code, and where the interpreter would
+            // service an interrupt before the next instruction.
+            if (generation != m_blockCache.generation() || pendingInterrupt().has_value())
+            {
+                completed = false;
+                break;
+            }
+        }
+        m_decoded = nullptr;
+
+        // An event running after the polling read may have changed the value
+        // the next iteration reads.
+        if (completed && block->idleLoop && m_registers.getPC() == block->startPC
+            && m_scheduler.now() < nextEvent)
+        {
+            skipIdleLoop(blockCycles);
+        }
+    }
+
+    int Processor::runDecoded(Processor& processor, const DecodedInstruction* decoded)
+    {
+        processor.m_decoded = decoded;
+        processor.m_registers.setPC(decoded->nextPC);
+
+        return decoded->execute(processor);
+    }
+
+#ifdef ANOTHERGB_JIT
+    int Processor::syncNative(Processor& processor, int cycles)
+    {
+        processor.updateClocks(cycles);
+        if (processor.m_blockCache.generation() != processor.m_nativeGeneration
+            || processor.pendingInterrupt().has_value())
+        {
+            return 0;
+        }
+        return processor.cyclesUntilNextEvent();
+    }
+#endif
+
+    int Processor::cyclesUntilNextEvent() const
+    {
+        uint64_t next = m_scheduler.nextTimestamp();
+        uint64_t now = m_scheduler.now();
+        if (next <= now)
+        {
+            return 0;
+        }
+        uint64_t left = next - now;
+        return (int)std::min<uint64_t>(left / 4 + (left % 4 != 0), std::numeric_limits<int>::max());
+    }
+
+    static bool endsBlock(uint8_t opCode)
+    {
+        switch (opCode)
+        {
+        case 0x10: case 0x76:                                   // stop, halt
+        case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // jr
+        case 0xC2: case 0xC3: case 0xCA: case 0xD2: case 0xDA: case 0xE9: // jp
+        case 0xC4: case 0xCC: case 0xCD: case 0xD4: case 0xDC: // call
+        case 0xC0: case 0xC8: case 0xC9: case 0xD0: case 0xD8: case 0xD9: // ret
+        case 0xC7: case 0xCF: case 0xD7: case 0xDF:
+        case 0xE7: case 0xEF: case 0xF7: case 0xFF:            // rst
+        case 0xF3: case 0xFB:                                   // di, ei
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Memory only changed by events (or by interrupt handlers, which only run
+    // after one).
+    static bool isEventDriven(uint16_t addr)
+    {
+        return addr == 0xFF0F || addr == 0xFF41 || addr == 0xFF44
+            || (addr >= 0xC000 && addr < 0xE000) || (addr >= 0xFF80 && addr < 0xFFFF);
+    }
+
+    // Instructions only reading or writing A and F, which keep the loop
+    // idempotent as A is reloaded at its start.
+    static bool isAccumulatorTest(uint16_t opCode)
+    {
+        switch (opCode)
+        {
+        case 0x00:                                  // nop
+        case 0xA7: case 0xB7: case 0xE6: case 0xF6: // and a, or a, and n, or n
+        case 0xEE: case 0xFE:                       // xor n, cp n
+            return true;
+        default:
+            return (opCode >= 0xB8 && opCode <= 0xBF) // cp r
+                || (opCode & 0xFFC7) == 0xCB47;       // bit n, a
+        }
+    }
+
+    // Matches loops like "ldh a, (0x44); cp 0x90; jr nz, loop": a read of an
+    // event driven location into A, tests on A, and a branch back.
+    static bool isIdleLoop(const Block& block)
+    {
+        if (block.instructions.size() < 2)
+        {
+            return false;
+        }
+
+        const DecodedInstruction& load = block.instructions.front();
+        bool eventDrivenLoad = (load.opCode == 0xF0 && isEventDriven(0xFF00 + load.operand)) // ldh a, (n)
+            || (load.opCode == 0xFA && isEventDriven(load.operand));                       // ld a, (nn)
+        if (!eventDrivenLoad)
+        {
+            return false;
+        }
+
+        for (size_t i = 1; i + 1 < block.instructions.size(); i++)
+        {
+            if (!isAccumulatorTest(block.instructions[i].opCode))
+            {
+                return false;
+            }
+        }
+
+        const DecodedInstruction& branch = block.instructions.back();
+        switch (branch.opCode)
+        {
+        case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // jr
+            return (uint16_t)(branch.nextPC + (int8_t)branch.operand) == block.startPC;
+        case 0xC2: case 0xC3: case 0xCA: case 0xD2: case 0xDA: // jp
+            return branch.operand == block.startPC;
+        default:
+            return false;
+        }
+    }
+
+    Block& Processor::decodeBlock(uint16_t bank, uint16_t pc)
+    {
+        Block block;
+        block.startPC = pc;
+
+        while (block.instructions.size() < BlockCache::maxBlockSize)
+        {
+            uint8_t opCode = m_memory.read8(pc);
+            uint8_t length = instructionLength(opCode);
+
+            // Keep the whole block inside a single cacheable region.
+            uint16_t last = pc + length - 1;
+            if (last < pc || !BlockCache::isCacheable(last) || ((last ^ block.startPC) & 0xC000) != 0)
+            {
+                break;
+            }
+
+            DecodedInstruction decoded = {};
+            if (opCode == 0xCB)
+            {
+                uint8_t cbOpCode = m_memory.read8(pc + 1);
+                decoded.execute = m_cbHandlers[cbOpCode];
+                decoded.opCode = 0xCB00 | cbOpCode;
+            }
+            else
+            {
+                decoded.execute = m_handlers[opCode];
+                decoded.opCode = opCode;
+                if (length == 2)
+                {
+                    decoded.operand = m_memory.read8(pc + 1);
+                }
+                else if (length == 3)
+                {
+                    decoded.operand = m_memory.read16(pc + 1);
+                }
+            }
+
+            pc += length;
+            decoded.nextPC = pc;
+            block.instructions.push_back(decoded);
+
+            if (endsBlock(opCode))
+            {
+                break;
+            }
+        }
+        block.endPC = pc;
+        block.idleLoop = isIdleLoop(block);
+
+        return m_blockCache.insert(bank, std::move(block));
+    }
+
+    bool Processor::fastForwardHalt()
+    {
+        // Any requested interrupt ends halt, even with IME cleared.
+        if (m_memory.pendingInterrupts() != 0)
+        {
+            m_isHalt = false;
+            m_isStopped = false;
+            return true;
+        }
+
+        // Only a scheduled event can request one while halted, skip to it.
+        // Waits one frame at most when nothing is scheduled.
+        uint64_t next = m_scheduler.nextTimestamp();
+        uint64_t cycles = next == utils::Scheduler::never ? 70224 : next - m_scheduler.now();
+        updateClocks(std::max<int>((cycles + 3) / 4, 1));
+        return false;
+    }
+
+    void Processor::skipIdleLoop(int iterationCycles)
+    {
+        // Iterations finishing by the next event all read the same values,
+        // the first one reading a changed value is run normally. Skips one
+        // frame at most when nothing is scheduled.
+        uint64_t next = m_scheduler.nextTimestamp();
+        uint64_t cycles = next == utils::Scheduler::never ? 70224 : next - m_scheduler.now();
+        uint64_t iterations = cycles / (iterationCycles * 4);
+        if (iterations == 0)
+        {
+            return;
+        }
+
+        int skipped = (int)(iterations * iterationCycles);
+        m_idleCyclesSkipped += skipped;
+        updateClocks(skipped);
     }
 
     void Processor::handleInterrupt(Interrupt interruptType)
@@ -85,27 +362,26 @@ namespace cpu
         m_IME = false;
         push(m_registers.getPC());
 
-        uint8_t ifFlag = m_memory.read8(0xFF0F);
         switch (interruptType)
         {
         case Interrupt::VBlank:
-            m_memory.write8(0xFF0F, ifFlag & ~0x01);
+            m_memory.acknowledgeInterrupt(0);
             m_registers.setPC(0x40);
             break;
         case Interrupt::LCD_STAT:
-            m_memory.write8(0xFF0F, ifFlag & ~0x02);
+            m_memory.acknowledgeInterrupt(1);
             m_registers.setPC(0x48);
             break;
         case Interrupt::Timer:
-            m_memory.write8(0xFF0F, ifFlag & ~0x04);
+            m_memory.acknowledgeInterrupt(2);
             m_registers.setPC(0x50);
             break;
         case Interrupt::Serial:
-            m_memory.write8(0xFF0F, ifFlag & ~0x08);
+            m_memory.acknowledgeInterrupt(3);
             m_registers.setPC(0x58);
             break;
         case Interrupt::Joypad:
-            m_memory.write8(0xFF0F, ifFlag & ~0x10);
+            m_memory.acknowledgeInterrupt(4);
             m_registers.setPC(0x60);
             break;
         }
@@ -113,25 +389,10 @@ namespace cpu
     
     void Processor::updateClocks(int ticks)
     {
-        m_divCycleCounter += ticks;
-        constexpr auto div_nb_cycles = number_of_cycle<DIV_frequency>();
-        if (m_divCycleCounter >= div_nb_cycles)
-        {
-            m_memory.incrementDIV();
-            m_divCycleCounter = m_divCycleCounter % div_nb_cycles;
-        }
+        m_cycles += ticks;
 
-        std::optional<int> timaNbCycles = getTIMANbCycles();
-        if (timaNbCycles.has_value())
-        {
-            m_timaCycleCounter += ticks;
-            if (m_timaCycleCounter >= timaNbCycles.value())
-            {
-                m_timaCycleCounter = m_timaCycleCounter % div_nb_cycles;
-                uint8_t tima = m_memory.read8(0xFF05);
-                m_memory.write8(0xFF05, tima + 1);
-            }
-        }
+        // The scheduler counts T-cycles.
+        m_scheduler.advance(ticks * 4);
     }
 
     std::optional<Interrupt> Processor::pendingInterrupt() const
@@ -140,9 +401,7 @@ namespace cpu
         {
             return std::nullopt;
         }
-        uint8_t if_flag = m_memory.read8(0xFF0F);
-        uint8_t ie_flag = m_memory.read8(0xFFFF);
-        if_flag = if_flag & ie_flag;
+        uint8_t if_flag = m_memory.pendingInterrupts();
         if ((if_flag & 0x01) == 0x01)
         {
             return Interrupt::VBlank;
@@ -170,513 +429,48 @@ namespace cpu
     void Processor::fillInstructionSet()
     {
         std::fill_n(m_instructionSet, 256, &Processor::unhandled);
-        
-        m_instructionSet[0x00] = &Processor::nop;
-        m_instructionSet[0x01] = &Processor::ld_rr_nn<Registers::BC>;
-        m_instructionSet[0x02] = &Processor::ld_r16_A<Registers::BC>;
-        m_instructionSet[0x03] = &Processor::inc_rr<Registers::BC>;
-        m_instructionSet[0x04] = &Processor::inc_r<Registers::B>;
-        m_instructionSet[0x05] = &Processor::dec_r<Registers::B>;
-        m_instructionSet[0x06] = &Processor::ld_r_n_8<0x06>;
-        m_instructionSet[0x07] = &Processor::rlca;
-        m_instructionSet[0x08] = &Processor::ld_nn_SP;
-        m_instructionSet[0x09] = &Processor::add_HL_rr<Registers::BC>;
-        m_instructionSet[0x0A] = &Processor::ld_A_r16<Registers::BC>;
-        m_instructionSet[0x0B] = &Processor::dec_rr<Registers::BC>;
-        m_instructionSet[0x0C] = &Processor::inc_r<Registers::C>;
-        m_instructionSet[0x0D] = &Processor::dec_r<Registers::C>;
-        m_instructionSet[0x0E] = &Processor::ld_r_n_8<0x0E>;
-        m_instructionSet[0x0F] = &Processor::rrca;
-        m_instructionSet[0x10] = &Processor::stop;
-        m_instructionSet[0x11] = &Processor::ld_rr_nn<Registers::DE>;
-        m_instructionSet[0x12] = &Processor::ld_r16_A<Registers::DE>;
-        m_instructionSet[0x13] = &Processor::inc_rr<Registers::DE>;
-        m_instructionSet[0x14] = &Processor::inc_r<Registers::D>;
-        m_instructionSet[0x15] = &Processor::dec_r<Registers::D>;
-        m_instructionSet[0x16] = &Processor::ld_r_n_8<0x16>;
-        m_instructionSet[0x17] = &Processor::rla;
-        m_instructionSet[0x18] = &Processor::jr_e;
-        m_instructionSet[0x19] = &Processor::add_HL_rr<Registers::DE>;
-        m_instructionSet[0x1A] = &Processor::ld_A_r16<Registers::DE>;
-        m_instructionSet[0x1B] = &Processor::dec_rr<Registers::DE>;
-        m_instructionSet[0x1C] = &Processor::inc_r<Registers::E>;
-        m_instructionSet[0x1D] = &Processor::dec_r<Registers::E>;
-        m_instructionSet[0x1E] = &Processor::ld_r_n_8<0x1E>;
-        m_instructionSet[0x1F] = &Processor::rra;
-        m_instructionSet[0x20] = &Processor::jr_ncc_n<Registers::Flag::Z>;
-        m_instructionSet[0x21] = &Processor::ld_rr_nn<Registers::HL>;
-        m_instructionSet[0x22] = &Processor::ld_HLi_A;
-        m_instructionSet[0x23] = &Processor::inc_rr<Registers::HL>;
-        m_instructionSet[0x24] = &Processor::inc_r<Registers::H>;
-        m_instructionSet[0x25] = &Processor::dec_r<Registers::H>;
-        m_instructionSet[0x26] = &Processor::ld_r_n_8<0x26>;
-        m_instructionSet[0x27] = &Processor::daa;
-        m_instructionSet[0x28] = &Processor::jr_cc_n<Registers::Flag::Z>;
-        m_instructionSet[0x29] = &Processor::add_HL_rr<Registers::HL>;
-        m_instructionSet[0x2A] = &Processor::ld_A_HLi;
-        m_instructionSet[0x2B] = &Processor::dec_rr<Registers::HL>;
-        m_instructionSet[0x2C] = &Processor::inc_r<Registers::L>;
-        m_instructionSet[0x2D] = &Processor::dec_r<Registers::L>;
-        m_instructionSet[0x2E] = &Processor::ld_r_n_8<0x2E>;
-        m_instructionSet[0x2F] = &Processor::cpl;
-        m_instructionSet[0x30] = &Processor::jr_ncc_n<Registers::Flag::C>;
-        m_instructionSet[0x31] = &Processor::ld_SP_nn;
-        m_instructionSet[0x32] = &Processor::ld_HLd_A;
-        m_instructionSet[0x33] = &Processor::inc_SP;
-        m_instructionSet[0x34] = &Processor::inc_HL;
-        m_instructionSet[0x35] = &Processor::dec_HL;
-        m_instructionSet[0x36] = &Processor::ld_HL_n_8<0x36>;
-        m_instructionSet[0x37] = &Processor::scf;
-        m_instructionSet[0x38] = &Processor::jr_cc_n<Registers::Flag::C>;
-        m_instructionSet[0x39] = &Processor::add_HL_SP;
-        m_instructionSet[0x3A] = &Processor::ld_A_HLd;
-        m_instructionSet[0x3B] = &Processor::dec_SP;
-        m_instructionSet[0x3C] = &Processor::inc_r<Registers::A>;
-        m_instructionSet[0x3D] = &Processor::dec_r<Registers::A>;
-        m_instructionSet[0x3E] = &Processor::ld_r_n_8<0x3E>;
-        m_instructionSet[0x3F] = &Processor::ccf;
-        m_instructionSet[0x40] = &Processor::ld_r_r_8<0x40>;
-        m_instructionSet[0x41] = &Processor::ld_r_r_8<0x41>;
-        m_instructionSet[0x42] = &Processor::ld_r_r_8<0x42>;
-        m_instructionSet[0x43] = &Processor::ld_r_r_8<0x43>;
-        m_instructionSet[0x44] = &Processor::ld_r_r_8<0x44>;
-        m_instructionSet[0x45] = &Processor::ld_r_r_8<0x45>;
-        m_instructionSet[0x46] = &Processor::ld_r_HL<0x46>;
-        m_instructionSet[0x47] = &Processor::ld_r_r_8<0x47>;
-        m_instructionSet[0x48] = &Processor::ld_r_r_8<0x48>;
-        m_instructionSet[0x49] = &Processor::ld_r_r_8<0x49>;
-        m_instructionSet[0x4A] = &Processor::ld_r_r_8<0x4A>;
-        m_instructionSet[0x4B] = &Processor::ld_r_r_8<0x4B>;
-        m_instructionSet[0x4C] = &Processor::ld_r_r_8<0x4C>;
-        m_instructionSet[0x4D] = &Processor::ld_r_r_8<0x4D>;
-        m_instructionSet[0x4E] = &Processor::ld_r_HL<0x4E>;
-        m_instructionSet[0x4F] = &Processor::ld_r_r_8<0x4F>;
-        m_instructionSet[0x50] = &Processor::ld_r_r_8<0x50>;
-        m_instructionSet[0x51] = &Processor::ld_r_r_8<0x51>;
-        m_instructionSet[0x52] = &Processor::ld_r_r_8<0x52>;
-        m_instructionSet[0x53] = &Processor::ld_r_r_8<0x53>;
-        m_instructionSet[0x54] = &Processor::ld_r_r_8<0x54>;
-        m_instructionSet[0x55] = &Processor::ld_r_r_8<0x55>;
-        m_instructionSet[0x56] = &Processor::ld_r_HL<0x56>;
-        m_instructionSet[0x57] = &Processor::ld_r_r_8<0x57>;
-        m_instructionSet[0x58] = &Processor::ld_r_r_8<0x58>;
-        m_instructionSet[0x59] = &Processor::ld_r_r_8<0x59>;
-        m_instructionSet[0x5A] = &Processor::ld_r_r_8<0x5A>;
-        m_instructionSet[0x5B] = &Processor::ld_r_r_8<0x5B>;
-        m_instructionSet[0x5C] = &Processor::ld_r_r_8<0x5C>;
-        m_instructionSet[0x5D] = &Processor::ld_r_r_8<0x5D>;
-        m_instructionSet[0x5E] = &Processor::ld_r_HL<0x5E>;
-        m_instructionSet[0x5F] = &Processor::ld_r_r_8<0x5F>;
-        m_instructionSet[0x60] = &Processor::ld_r_r_8<0x60>;
-        m_instructionSet[0x61] = &Processor::ld_r_r_8<0x61>;
-        m_instructionSet[0x62] = &Processor::ld_r_r_8<0x62>;
-        m_instructionSet[0x63] = &Processor::ld_r_r_8<0x63>;
-        m_instructionSet[0x64] = &Processor::ld_r_r_8<0x64>;
-        m_instructionSet[0x65] = &Processor::ld_r_r_8<0x65>;
-        m_instructionSet[0x66] = &Processor::ld_r_HL<0x66>;
-        m_instructionSet[0x67] = &Processor::ld_r_r_8<0x67>;
-        m_instructionSet[0x68] = &Processor::ld_r_r_8<0x68>;
-        m_instructionSet[0x69] = &Processor::ld_r_r_8<0x69>;
-        m_instructionSet[0x6A] = &Processor::ld_r_r_8<0x6A>;
-        m_instructionSet[0x6B] = &Processor::ld_r_r_8<0x6B>;
-        m_instructionSet[0x6C] = &Processor::ld_r_r_8<0x6C>;
-        m_instructionSet[0x6D] = &Processor::ld_r_r_8<0x6D>;
-        m_instructionSet[0x6E] = &Processor::ld_r_HL<0x6E>;
-        m_instructionSet[0x6F] = &Processor::ld_r_r_8<0x6F>;
-        m_instructionSet[0x70] = &Processor::ld_HL_r<0x70>;
-        m_instructionSet[0x71] = &Processor::ld_HL_r<0x71>;
-        m_instructionSet[0x72] = &Processor::ld_HL_r<0x72>;
-        m_instructionSet[0x73] = &Processor::ld_HL_r<0x73>;
-        m_instructionSet[0x74] = &Processor::ld_HL_r<0x74>;
-        m_instructionSet[0x75] = &Processor::ld_HL_r<0x75>;
-        m_instructionSet[0x76] = &Processor::halt;
-        m_instructionSet[0x77] = &Processor::ld_HL_r<0x77>;
-        m_instructionSet[0x78] = &Processor::ld_r_r_8<0x78>;
-        m_instructionSet[0x79] = &Processor::ld_r_r_8<0x79>;
-        m_instructionSet[0x7A] = &Processor::ld_r_r_8<0x7A>;
-        m_instructionSet[0x7B] = &Processor::ld_r_r_8<0x7B>;
-        m_instructionSet[0x7C] = &Processor::ld_r_r_8<0x7C>;
-        m_instructionSet[0x7D] = &Processor::ld_r_r_8<0x7D>;
-        m_instructionSet[0x7E] = &Processor::ld_r_HL<0x7E>;
-        m_instructionSet[0x7F] = &Processor::ld_r_r_8<0x7F>;
-        m_instructionSet[0x80] = &Processor::add_r<Registers::B>;
-        m_instructionSet[0x81] = &Processor::add_r<Registers::C>;
-        m_instructionSet[0x82] = &Processor::add_r<Registers::D>;
-        m_instructionSet[0x83] = &Processor::add_r<Registers::E>;
-        m_instructionSet[0x84] = &Processor::add_r<Registers::H>;
-        m_instructionSet[0x85] = &Processor::add_r<Registers::L>;
-        m_instructionSet[0x86] = &Processor::add_HL;
-        m_instructionSet[0x87] = &Processor::add_r<Registers::A>;
-        m_instructionSet[0x88] = &Processor::adc_r<Registers::B>;
-        m_instructionSet[0x89] = &Processor::adc_r<Registers::C>;
-        m_instructionSet[0x8A] = &Processor::adc_r<Registers::D>;
-        m_instructionSet[0x8B] = &Processor::adc_r<Registers::E>;
-        m_instructionSet[0x8C] = &Processor::adc_r<Registers::H>;
-        m_instructionSet[0x8D] = &Processor::adc_r<Registers::L>;
-        m_instructionSet[0x8E] = &Processor::adc_HL;
-        m_instructionSet[0x8F] = &Processor::adc_r<Registers::A>;
-        m_instructionSet[0x90] = &Processor::sub_r<Registers::B>;
-        m_instructionSet[0x91] = &Processor::sub_r<Registers::C>;
-        m_instructionSet[0x92] = &Processor::sub_r<Registers::D>;
-        m_instructionSet[0x93] = &Processor::sub_r<Registers::E>;
-        m_instructionSet[0x94] = &Processor::sub_r<Registers::H>;
-        m_instructionSet[0x95] = &Processor::sub_r<Registers::L>;
-        m_instructionSet[0x96] = &Processor::sub_HL;
-        m_instructionSet[0x97] = &Processor::sub_r<Registers::A>;
-        m_instructionSet[0x98] = &Processor::sbc_r<Registers::B>;
-        m_instructionSet[0x99] = &Processor::sbc_r<Registers::C>;
-        m_instructionSet[0x9A] = &Processor::sbc_r<Registers::D>;
-        m_instructionSet[0x9B] = &Processor::sbc_r<Registers::E>;
-        m_instructionSet[0x9C] = &Processor::sbc_r<Registers::H>;
-        m_instructionSet[0x9D] = &Processor::sbc_r<Registers::L>;
-        m_instructionSet[0x9E] = &Processor::sbc_HL;
-        m_instructionSet[0x9F] = &Processor::sbc_r<Registers::A>;
-        m_instructionSet[0xA0] = &Processor::and_r<Registers::B>;
-        m_instructionSet[0xA1] = &Processor::and_r<Registers::C>;
-        m_instructionSet[0xA2] = &Processor::and_r<Registers::D>;
-        m_instructionSet[0xA3] = &Processor::and_r<Registers::E>;
-        m_instructionSet[0xA4] = &Processor::and_r<Registers::H>;
-        m_instructionSet[0xA5] = &Processor::and_r<Registers::L>;
-        m_instructionSet[0xA6] = &Processor::and_HL;
-        m_instructionSet[0xA7] = &Processor::and_r<Registers::A>;
-        m_instructionSet[0xA8] = &Processor::xor_r<Registers::B>;
-        m_instructionSet[0xA9] = &Processor::xor_r<Registers::C>;
-        m_instructionSet[0xAA] = &Processor::xor_r<Registers::D>;
-        m_instructionSet[0xAB] = &Processor::xor_r<Registers::E>;
-        m_instructionSet[0xAC] = &Processor::xor_r<Registers::H>;
-        m_instructionSet[0xAD] = &Processor::xor_r<Registers::L>;
-        m_instructionSet[0xAE] = &Processor::xor_HL;
-        m_instructionSet[0xAF] = &Processor::xor_r<Registers::A>;
-        m_instructionSet[0xB0] = &Processor::or_r<Registers::B>;
-        m_instructionSet[0xB1] = &Processor::or_r<Registers::C>;
-        m_instructionSet[0xB2] = &Processor::or_r<Registers::D>;
-        m_instructionSet[0xB3] = &Processor::or_r<Registers::E>;
-        m_instructionSet[0xB4] = &Processor::or_r<Registers::H>;
-        m_instructionSet[0xB5] = &Processor::or_r<Registers::L>;
-        m_instructionSet[0xB6] = &Processor::or_HL;
-        m_instructionSet[0xB7] = &Processor::or_r<Registers::A>;
-        m_instructionSet[0xB8] = &Processor::cp_r<Registers::B>;
-        m_instructionSet[0xB9] = &Processor::cp_r<Registers::C>;
-        m_instructionSet[0xBA] = &Processor::cp_r<Registers::D>;
-        m_instructionSet[0xBB] = &Processor::cp_r<Registers::E>;
-        m_instructionSet[0xBC] = &Processor::cp_r<Registers::H>;
-        m_instructionSet[0xBD] = &Processor::cp_r<Registers::L>;
-        m_instructionSet[0xBE] = &Processor::cp_HL;
-        m_instructionSet[0xBF] = &Processor::cp_r<Registers::A>;
-        m_instructionSet[0xC0] = &Processor::ret_ncc<Registers::Flag::Z>;
-        m_instructionSet[0xC1] = &Processor::pop_rr<Registers::BC>;
-        m_instructionSet[0xC2] = &Processor::jp_ncc_nn<Registers::Flag::Z>;
-        m_instructionSet[0xC3] = &Processor::jp_nn;
-        m_instructionSet[0xC4] = &Processor::call_ncc_nn<Registers::Flag::Z>;
-        m_instructionSet[0xC5] = &Processor::push_rr<Registers::BC>;
-        m_instructionSet[0xC6] = &Processor::add_n;
-        m_instructionSet[0xC7] = &Processor::rst<0x00>;
-        m_instructionSet[0xC8] = &Processor::ret_cc<Registers::Flag::Z>;
-        m_instructionSet[0xC9] = &Processor::ret;
-        m_instructionSet[0xCA] = &Processor::jp_cc_nn<Registers::Flag::Z>;
-        m_instructionSet[0xCB] = &Processor::cb;
-        m_instructionSet[0xCC] = &Processor::call_cc_nn<Registers::Flag::Z>;
-        m_instructionSet[0xCD] = &Processor::call_nn;
-        m_instructionSet[0xCE] = &Processor::adc_n;
-        m_instructionSet[0xCF] = &Processor::rst<0x08>;
-        m_instructionSet[0xD0] = &Processor::ret_ncc<Registers::Flag::C>;
-        m_instructionSet[0xD1] = &Processor::pop_rr<Registers::DE>;
-        m_instructionSet[0xD2] = &Processor::jp_ncc_nn<Registers::Flag::C>;
-        m_instructionSet[0xD4] = &Processor::call_ncc_nn<Registers::Flag::C>;
-        m_instructionSet[0xD5] = &Processor::push_rr<Registers::DE>;
-        m_instructionSet[0xD6] = &Processor::sub_n;
-        m_instructionSet[0xD7] = &Processor::rst<0x10>;
-        m_instructionSet[0xD8] = &Processor::ret_cc<Registers::Flag::C>;
-        m_instructionSet[0xD9] = &Processor::reti;
-        m_instructionSet[0xDA] = &Processor::jp_cc_nn<Registers::Flag::C>;
-        m_instructionSet[0xDC] = &Processor::call_cc_nn<Registers::Flag::C>;
-        m_instructionSet[0xDE] = &Processor::sbc_n;
-        m_instructionSet[0xDF] = &Processor::rst<0x18>;
-        m_instructionSet[0xE0] = &Processor::ldh_an_A;
-        m_instructionSet[0xE1] = &Processor::pop_rr<Registers::HL>;
-        m_instructionSet[0xE2] = &Processor::ldh_aC_A;
-        m_instructionSet[0xE5] = &Processor::push_rr<Registers::HL>;
-        m_instructionSet[0xE6] = &Processor::and_n;
-        m_instructionSet[0xE7] = &Processor::rst<0x20>;
-        m_instructionSet[0xE8] = &Processor::add_SP_n;
-        m_instructionSet[0xE9] = &Processor::jp_HL;
-        m_instructionSet[0xEA] = &Processor::ld_nn_A;
-        m_instructionSet[0xEE] = &Processor::xor_n;
-        m_instructionSet[0xEF] = &Processor::rst<0x28>;
-        m_instructionSet[0xF0] = &Processor::ldh_A_an;
-        m_instructionSet[0xF1] = &Processor::pop_rr<Registers::AF>;
-        m_instructionSet[0xF2] = &Processor::ldh_A_aC;
-        m_instructionSet[0xF3] = &Processor::di;
-        m_instructionSet[0xF5] = &Processor::push_rr<Registers::AF>;
-        m_instructionSet[0xF6] = &Processor::or_n;
-        m_instructionSet[0xF7] = &Processor::rst<0x30>;
-        m_instructionSet[0xF8] = &Processor::ld_HL_SP_r8;
-        m_instructionSet[0xF9] = &Processor::ld_SP_HL;
-        m_instructionSet[0xFA] = &Processor::ld_A_nn;
-        m_instructionSet[0xFB] = &Processor::ei;
-        m_instructionSet[0xFE] = &Processor::cp_n;
-        m_instructionSet[0xFF] = &Processor::rst<0x38>;
+        std::fill_n(m_handlers, 256, &Processor::call<&Processor::unhandled>);
+
+#define X(opcode, ...) \
+        m_instructionSet[opcode] = &Processor::__VA_ARGS__; \
+        m_handlers[opcode] = &Processor::call<&Processor::__VA_ARGS__>;
+        GB_OPCODES(X)
+#undef X
     }
 
     void Processor::fillCbInstructionSet()
     {
-        m_cbInstructionSet[0x00] = &Processor::rlc_r<Registers::B>;
-        m_cbInstructionSet[0x01] = &Processor::rlc_r<Registers::C>;
-        m_cbInstructionSet[0x02] = &Processor::rlc_r<Registers::D>;
-        m_cbInstructionSet[0x03] = &Processor::rlc_r<Registers::E>;
-        m_cbInstructionSet[0x04] = &Processor::rlc_r<Registers::H>;
-        m_cbInstructionSet[0x05] = &Processor::rlc_r<Registers::L>;
-        m_cbInstructionSet[0x06] = &Processor::rlc_HL;
-        m_cbInstructionSet[0x07] = &Processor::rlc_r<Registers::A>;
-        m_cbInstructionSet[0x08] = &Processor::rrc_r<Registers::B>;
-        m_cbInstructionSet[0x09] = &Processor::rrc_r<Registers::C>;
-        m_cbInstructionSet[0x0A] = &Processor::rrc_r<Registers::D>;
-        m_cbInstructionSet[0x0B] = &Processor::rrc_r<Registers::E>;
-        m_cbInstructionSet[0x0C] = &Processor::rrc_r<Registers::H>;
-        m_cbInstructionSet[0x0D] = &Processor::rrc_r<Registers::L>;
-        m_cbInstructionSet[0x0E] = &Processor::rrc_HL;
-        m_cbInstructionSet[0x0F] = &Processor::rrc_r<Registers::A>;
-        m_cbInstructionSet[0x10] = &Processor::rl_r<Registers::B>;
-        m_cbInstructionSet[0x11] = &Processor::rl_r<Registers::C>;
-        m_cbInstructionSet[0x12] = &Processor::rl_r<Registers::D>;
-        m_cbInstructionSet[0x13] = &Processor::rl_r<Registers::E>;
-        m_cbInstructionSet[0x14] = &Processor::rl_r<Registers::H>;
-        m_cbInstructionSet[0x15] = &Processor::rl_r<Registers::L>;
-        m_cbInstructionSet[0x16] = &Processor::rl_HL;
-        m_cbInstructionSet[0x17] = &Processor::rl_r<Registers::A>;
-        m_cbInstructionSet[0x18] = &Processor::rr_r<Registers::B>;
-        m_cbInstructionSet[0x19] = &Processor::rr_r<Registers::C>;
-        m_cbInstructionSet[0x1A] = &Processor::rr_r<Registers::D>;
-        m_cbInstructionSet[0x1B] = &Processor::rr_r<Registers::E>;
-        m_cbInstructionSet[0x1C] = &Processor::rr_r<Registers::H>;
-        m_cbInstructionSet[0x1D] = &Processor::rr_r<Registers::L>;
-        m_cbInstructionSet[0x1E] = &Processor::rr_HL;
-        m_cbInstructionSet[0x1F] = &Processor::rr_r<Registers::A>;
-        m_cbInstructionSet[0x20] = &Processor::sla_r<Registers::B>;
-        m_cbInstructionSet[0x21] = &Processor::sla_r<Registers::C>;
-        m_cbInstructionSet[0x22] = &Processor::sla_r<Registers::D>;
-        m_cbInstructionSet[0x23] = &Processor::sla_r<Registers::E>;
-        m_cbInstructionSet[0x24] = &Processor::sla_r<Registers::H>;
-        m_cbInstructionSet[0x25] = &Processor::sla_r<Registers::L>;
-        m_cbInstructionSet[0x26] = &Processor::sla_HL;
-        m_cbInstructionSet[0x27] = &Processor::sla_r<Registers::A>;
-        m_cbInstructionSet[0x28] = &Processor::sra_r<Registers::B>;
-        m_cbInstructionSet[0x29] = &Processor::sra_r<Registers::C>;
-        m_cbInstructionSet[0x2A] = &Processor::sra_r<Registers::D>;
-        m_cbInstructionSet[0x2B] = &Processor::sra_r<Registers::E>;
-        m_cbInstructionSet[0x2C] = &Processor::sra_r<Registers::H>;
-        m_cbInstructionSet[0x2D] = &Processor::sra_r<Registers::L>;
-        m_cbInstructionSet[0x2E] = &Processor::sra_HL;
-        m_cbInstructionSet[0x2F] = &Processor::sra_r<Registers::A>;
-        m_cbInstructionSet[0x2F] = &Processor::swap_r<Registers::A>;
-        m_cbInstructionSet[0x30] = &Processor::swap_r<Registers::B>;
-        m_cbInstructionSet[0x31] = &Processor::swap_r<Registers::C>;
-        m_cbInstructionSet[0x32] = &Processor::swap_r<Registers::D>;
-        m_cbInstructionSet[0x33] = &Processor::swap_r<Registers::E>;
-        m_cbInstructionSet[0x34] = &Processor::swap_r<Registers::H>;
-        m_cbInstructionSet[0x35] = &Processor::swap_r<Registers::L>;
-        m_cbInstructionSet[0x36] = &Processor::swap_HL;
-        m_cbInstructionSet[0x37] = &Processor::swap_r<Registers::A>;
-        m_cbInstructionSet[0x38] = &Processor::srl_r<Registers::B>;
-        m_cbInstructionSet[0x39] = &Processor::srl_r<Registers::C>;
-        m_cbInstructionSet[0x3A] = &Processor::srl_r<Registers::D>;
-        m_cbInstructionSet[0x3B] = &Processor::srl_r<Registers::E>;
-        m_cbInstructionSet[0x3C] = &Processor::srl_r<Registers::H>;
-        m_cbInstructionSet[0x3D] = &Processor::srl_r<Registers::L>;
-        m_cbInstructionSet[0x3E] = &Processor::srl_HL;
-        m_cbInstructionSet[0x3F] = &Processor::srl_r<Registers::A>;
-        m_cbInstructionSet[0x40] = &Processor::bit_n_r<0, Registers::B>;
-        m_cbInstructionSet[0x41] = &Processor::bit_n_r<0, Registers::C>;
-        m_cbInstructionSet[0x42] = &Processor::bit_n_r<0, Registers::D>;
-        m_cbInstructionSet[0x43] = &Processor::bit_n_r<0, Registers::E>;
-        m_cbInstructionSet[0x44] = &Processor::bit_n_r<0, Registers::H>;
-        m_cbInstructionSet[0x45] = &Processor::bit_n_r<0, Registers::L>;
-        m_cbInstructionSet[0x46] = &Processor::bit_n_HL<0>;
-        m_cbInstructionSet[0x47] = &Processor::bit_n_r<0, Registers::A>;
-        m_cbInstructionSet[0x48] = &Processor::bit_n_r<1, Registers::B>;
-        m_cbInstructionSet[0x49] = &Processor::bit_n_r<1, Registers::C>;
-        m_cbInstructionSet[0x4A] = &Processor::bit_n_r<1, Registers::D>;
-        m_cbInstructionSet[0x4B] = &Processor::bit_n_r<1, Registers::E>;
-        m_cbInstructionSet[0x4C] = &Processor::bit_n_r<1, Registers::H>;
-        m_cbInstructionSet[0x4D] = &Processor::bit_n_r<1, Registers::L>;
-        m_cbInstructionSet[0x4E] = &Processor::bit_n_HL<1>;
-        m_cbInstructionSet[0x4F] = &Processor::bit_n_r<1, Registers::A>;
-        m_cbInstructionSet[0x50] = &Processor::bit_n_r<2, Registers::B>;
-        m_cbInstructionSet[0x51] = &Processor::bit_n_r<2, Registers::C>;
-        m_cbInstructionSet[0x52] = &Processor::bit_n_r<2, Registers::D>;
-        m_cbInstructionSet[0x53] = &Processor::bit_n_r<2, Registers::E>;
-        m_cbInstructionSet[0x54] = &Processor::bit_n_r<2, Registers::H>;
-        m_cbInstructionSet[0x55] = &Processor::bit_n_r<2, Registers::L>;
-        m_cbInstructionSet[0x56] = &Processor::bit_n_HL<2>;
-        m_cbInstructionSet[0x57] = &Processor::bit_n_r<2, Registers::A>;
-        m_cbInstructionSet[0x58] = &Processor::bit_n_r<3, Registers::B>;
-        m_cbInstructionSet[0x59] = &Processor::bit_n_r<3, Registers::C>;
-        m_cbInstructionSet[0x5A] = &Processor::bit_n_r<3, Registers::D>;
-        m_cbInstructionSet[0x5B] = &Processor::bit_n_r<3, Registers::E>;
-        m_cbInstructionSet[0x5C] = &Processor::bit_n_r<3, Registers::H>;
-        m_cbInstructionSet[0x5D] = &Processor::bit_n_r<3, Registers::L>;
-        m_cbInstructionSet[0x5E] = &Processor::bit_n_HL<3>;
-        m_cbInstructionSet[0x5F] = &Processor::bit_n_r<3, Registers::A>;
-        m_cbInstructionSet[0x60] = &Processor::bit_n_r<4, Registers::B>;
-        m_cbInstructionSet[0x61] = &Processor::bit_n_r<4, Registers::C>;
-        m_cbInstructionSet[0x62] = &Processor::bit_n_r<4, Registers::D>;
-        m_cbInstructionSet[0x63] = &Processor::bit_n_r<4, Registers::E>;
-        m_cbInstructionSet[0x64] = &Processor::bit_n_r<4, Registers::H>;
-        m_cbInstructionSet[0x65] = &Processor::bit_n_r<4, Registers::L>;
-        m_cbInstructionSet[0x66] = &Processor::bit_n_HL<4>;
-        m_cbInstructionSet[0x67] = &Processor::bit_n_r<4, Registers::A>;
-        m_cbInstructionSet[0x68] = &Processor::bit_n_r<5, Registers::B>;
-        m_cbInstructionSet[0x69] = &Processor::bit_n_r<5, Registers::C>;
-        m_cbInstructionSet[0x6A] = &Processor::bit_n_r<5, Registers::D>;
-        m_cbInstructionSet[0x6B] = &Processor::bit_n_r<5, Registers::E>;
-        m_cbInstructionSet[0x6C] = &Processor::bit_n_r<5, Registers::H>;
-        m_cbInstructionSet[0x6D] = &Processor::bit_n_r<5, Registers::L>;
-        m_cbInstructionSet[0x6E] = &Processor::bit_n_HL<5>;
-        m_cbInstructionSet[0x6F] = &Processor::bit_n_r<5, Registers::A>;
-        m_cbInstructionSet[0x70] = &Processor::bit_n_r<6, Registers::B>;
-        m_cbInstructionSet[0x71] = &Processor::bit_n_r<6, Registers::C>;
-        m_cbInstructionSet[0x72] = &Processor::bit_n_r<6, Registers::D>;
-        m_cbInstructionSet[0x73] = &Processor::bit_n_r<6, Registers::E>;
-        m_cbInstructionSet[0x74] = &Processor::bit_n_r<6, Registers::H>;
-        m_cbInstructionSet[0x75] = &Processor::bit_n_r<6, Registers::L>;
-        m_cbInstructionSet[0x76] = &Processor::bit_n_HL<6>;
-        m_cbInstructionSet[0x77] = &Processor::bit_n_r<6, Registers::A>;
-        m_cbInstructionSet[0x78] = &Processor::bit_n_r<7, Registers::B>;
-        m_cbInstructionSet[0x79] = &Processor::bit_n_r<7, Registers::C>;
-        m_cbInstructionSet[0x7A] = &Processor::bit_n_r<7, Registers::D>;
-        m_cbInstructionSet[0x7B] = &Processor::bit_n_r<7, Registers::E>;
-        m_cbInstructionSet[0x7C] = &Processor::bit_n_r<7, Registers::H>;
-        m_cbInstructionSet[0x7D] = &Processor::bit_n_r<7, Registers::L>;
-        m_cbInstructionSet[0x7E] = &Processor::bit_n_HL<7>;
-        m_cbInstructionSet[0x7F] = &Processor::bit_n_r<7, Registers::A>;
-        m_cbInstructionSet[0x80] = &Processor::res_n_r<0, Registers::B>;
-        m_cbInstructionSet[0x81] = &Processor::res_n_r<0, Registers::C>;
-        m_cbInstructionSet[0x82] = &Processor::res_n_r<0, Registers::D>;
-        m_cbInstructionSet[0x83] = &Processor::res_n_r<0, Registers::E>;
-        m_cbInstructionSet[0x84] = &Processor::res_n_r<0, Registers::H>;
-        m_cbInstructionSet[0x85] = &Processor::res_n_r<0, Registers::L>;
-        m_cbInstructionSet[0x86] = &Processor::res_n_HL<0>;
-        m_cbInstructionSet[0x87] = &Processor::res_n_r<0, Registers::A>;
-        m_cbInstructionSet[0x88] = &Processor::res_n_r<1, Registers::B>;
-        m_cbInstructionSet[0x89] = &Processor::res_n_r<1, Registers::C>;
-        m_cbInstructionSet[0x8A] = &Processor::res_n_r<1, Registers::D>;
-        m_cbInstructionSet[0x8B] = &Processor::res_n_r<1, Registers::E>;
-        m_cbInstructionSet[0x8C] = &Processor::res_n_r<1, Registers::H>;
-        m_cbInstructionSet[0x8D] = &Processor::res_n_r<1, Registers::L>;
-        m_cbInstructionSet[0x8E] = &Processor::res_n_HL<1>;
-        m_cbInstructionSet[0x8F] = &Processor::res_n_r<1, Registers::A>;
-        m_cbInstructionSet[0x90] = &Processor::res_n_r<2, Registers::B>;
-        m_cbInstructionSet[0x91] = &Processor::res_n_r<2, Registers::C>;
-        m_cbInstructionSet[0x92] = &Processor::res_n_r<2, Registers::D>;
-        m_cbInstructionSet[0x93] = &Processor::res_n_r<2, Registers::E>;
-        m_cbInstructionSet[0x94] = &Processor::res_n_r<2, Registers::H>;
-        m_cbInstructionSet[0x95] = &Processor::res_n_r<2, Registers::L>;
-        m_cbInstructionSet[0x96] = &Processor::res_n_HL<2>;
-        m_cbInstructionSet[0x97] = &Processor::res_n_r<2, Registers::A>;
-        m_cbInstructionSet[0x98] = &Processor::res_n_r<3, Registers::B>;
-        m_cbInstructionSet[0x99] = &Processor::res_n_r<3, Registers::C>;
-        m_cbInstructionSet[0x9A] = &Processor::res_n_r<3, Registers::D>;
-        m_cbInstructionSet[0x9B] = &Processor::res_n_r<3, Registers::E>;
-        m_cbInstructionSet[0x9C] = &Processor::res_n_r<3, Registers::H>;
-        m_cbInstructionSet[0x9D] = &Processor::res_n_r<3, Registers::L>;
-        m_cbInstructionSet[0x9E] = &Processor::res_n_HL<3>;
-        m_cbInstructionSet[0x9F] = &Processor::res_n_r<3, Registers::A>;
-        m_cbInstructionSet[0xA0] = &Processor::res_n_r<4, Registers::B>;
-        m_cbInstructionSet[0xA1] = &Processor::res_n_r<4, Registers::C>;
-        m_cbInstructionSet[0xA2] = &Processor::res_n_r<4, Registers::D>;
-        m_cbInstructionSet[0xA3] = &Processor::res_n_r<4, Registers::E>;
-        m_cbInstructionSet[0xA4] = &Processor::res_n_r<4, Registers::H>;
-        m_cbInstructionSet[0xA5] = &Processor::res_n_r<4, Registers::L>;
-        m_cbInstructionSet[0xA6] = &Processor::res_n_HL<4>;
-        m_cbInstructionSet[0xA7] = &Processor::res_n_r<4, Registers::A>;
-        m_cbInstructionSet[0xA8] = &Processor::res_n_r<5, Registers::B>;
-        m_cbInstructionSet[0xA9] = &Processor::res_n_r<5, Registers::C>;
-        m_cbInstructionSet[0xAA] = &Processor::res_n_r<5, Registers::D>;
-        m_cbInstructionSet[0xAB] = &Processor::res_n_r<5, Registers::E>;
-        m_cbInstructionSet[0xAC] = &Processor::res_n_r<5, Registers::H>;
-        m_cbInstructionSet[0xAD] = &Processor::res_n_r<5, Registers::L>;
-        m_cbInstructionSet[0xAE] = &Processor::res_n_HL<5>;
-        m_cbInstructionSet[0xAF] = &Processor::res_n_r<5, Registers::A>;
-        m_cbInstructionSet[0xB0] = &Processor::res_n_r<6, Registers::B>;
-        m_cbInstructionSet[0xB1] = &Processor::res_n_r<6, Registers::C>;
-        m_cbInstructionSet[0xB2] = &Processor::res_n_r<6, Registers::D>;
-        m_cbInstructionSet[0xB3] = &Processor::res_n_r<6, Registers::E>;
-        m_cbInstructionSet[0xB4] = &Processor::res_n_r<6, Registers::H>;
-        m_cbInstructionSet[0xB5] = &Processor::res_n_r<6, Registers::L>;
-        m_cbInstructionSet[0xB6] = &Processor::res_n_HL<6>;
-        m_cbInstructionSet[0xB7] = &Processor::res_n_r<6, Registers::A>;
-        m_cbInstructionSet[0xB8] = &Processor::res_n_r<7, Registers::B>;
-        m_cbInstructionSet[0xB9] = &Processor::res_n_r<7, Registers::C>;
-        m_cbInstructionSet[0xBA] = &Processor::res_n_r<7, Registers::D>;
-        m_cbInstructionSet[0xBB] = &Processor::res_n_r<7, Registers::E>;
-        m_cbInstructionSet[0xBC] = &Processor::res_n_r<7, Registers::H>;
-        m_cbInstructionSet[0xBD] = &Processor::res_n_r<7, Registers::L>;
-        m_cbInstructionSet[0xBE] = &Processor::res_n_HL<7>;
-        m_cbInstructionSet[0xBF] = &Processor::res_n_r<7, Registers::A>;
-        m_cbInstructionSet[0xC0] = &Processor::set_n_r<0, Registers::B>;
-        m_cbInstructionSet[0xC1] = &Processor::set_n_r<0, Registers::C>;
-        m_cbInstructionSet[0xC2] = &Processor::set_n_r<0, Registers::D>;
-        m_cbInstructionSet[0xC3] = &Processor::set_n_r<0, Registers::E>;
-        m_cbInstructionSet[0xC4] = &Processor::set_n_r<0, Registers::H>;
-        m_cbInstructionSet[0xC5] = &Processor::set_n_r<0, Registers::L>;
-        m_cbInstructionSet[0xC6] = &Processor::set_n_HL<0>;
-        m_cbInstructionSet[0xC7] = &Processor::set_n_r<0, Registers::A>;
-        m_cbInstructionSet[0xC8] = &Processor::set_n_r<1, Registers::B>;
-        m_cbInstructionSet[0xC9] = &Processor::set_n_r<1, Registers::C>;
-        m_cbInstructionSet[0xCA] = &Processor::set_n_r<1, Registers::D>;
-        m_cbInstructionSet[0xCB] = &Processor::set_n_r<1, Registers::E>;
-        m_cbInstructionSet[0xCC] = &Processor::set_n_r<1, Registers::H>;
-        m_cbInstructionSet[0xCD] = &Processor::set_n_r<1, Registers::L>;
-        m_cbInstructionSet[0xCE] = &Processor::set_n_HL<1>;
-        m_cbInstructionSet[0xCF] = &Processor::set_n_r<1, Registers::A>;
-        m_cbInstructionSet[0xD0] = &Processor::set_n_r<2, Registers::B>;
-        m_cbInstructionSet[0xD1] = &Processor::set_n_r<2, Registers::C>;
-        m_cbInstructionSet[0xD2] = &Processor::set_n_r<2, Registers::D>;
-        m_cbInstructionSet[0xD3] = &Processor::set_n_r<2, Registers::E>;
-        m_cbInstructionSet[0xD4] = &Processor::set_n_r<2, Registers::H>;
-        m_cbInstructionSet[0xD5] = &Processor::set_n_r<2, Registers::L>;
-        m_cbInstructionSet[0xD6] = &Processor::set_n_HL<2>;
-        m_cbInstructionSet[0xD7] = &Processor::set_n_r<2, Registers::A>;
-        m_cbInstructionSet[0xD8] = &Processor::set_n_r<3, Registers::B>;
-        m_cbInstructionSet[0xD9] = &Processor::set_n_r<3, Registers::C>;
-        m_cbInstructionSet[0xDA] = &Processor::set_n_r<3, Registers::D>;
-        m_cbInstructionSet[0xDB] = &Processor::set_n_r<3, Registers::E>;
-        m_cbInstructionSet[0xDC] = &Processor::set_n_r<3, Registers::H>;
-        m_cbInstructionSet[0xDD] = &Processor::set_n_r<3, Registers::L>;
-        m_cbInstructionSet[0xDE] = &Processor::set_n_HL<3>;
-        m_cbInstructionSet[0xDF] = &Processor::set_n_r<3, Registers::A>;
-        m_cbInstructionSet[0xE0] = &Processor::set_n_r<4, Registers::B>;
-        m_cbInstructionSet[0xE1] = &Processor::set_n_r<4, Registers::C>;
-        m_cbInstructionSet[0xE2] = &Processor::set_n_r<4, Registers::D>;
-        m_cbInstructionSet[0xE3] = &Processor::set_n_r<4, Registers::E>;
-        m_cbInstructionSet[0xE4] = &Processor::set_n_r<4, Registers::H>;
-        m_cbInstructionSet[0xE5] = &Processor::set_n_r<4, Registers::L>;
-        m_cbInstructionSet[0xE6] = &Processor::set_n_HL<4>;
-        m_cbInstructionSet[0xE7] = &Processor::set_n_r<4, Registers::A>;
-        m_cbInstructionSet[0xE8] = &Processor::set_n_r<5, Registers::B>;
-        m_cbInstructionSet[0xE9] = &Processor::set_n_r<5, Registers::C>;
-        m_cbInstructionSet[0xEA] = &Processor::set_n_r<5, Registers::D>;
-        m_cbInstructionSet[0xEB] = &Processor::set_n_r<5, Registers::E>;
-        m_cbInstructionSet[0xEC] = &Processor::set_n_r<5, Registers::H>;
-        m_cbInstructionSet[0xED] = &Processor::set_n_r<5, Registers::L>;
-        m_cbInstructionSet[0xEE] = &Processor::set_n_HL<5>;
-        m_cbInstructionSet[0xEF] = &Processor::set_n_r<5, Registers::A>;
-        m_cbInstructionSet[0xF0] = &Processor::set_n_r<6, Registers::B>;
-        m_cbInstructionSet[0xF1] = &Processor::set_n_r<6, Registers::C>;
-        m_cbInstructionSet[0xF2] = &Processor::set_n_r<6, Registers::D>;
-        m_cbInstructionSet[0xF3] = &Processor::set_n_r<6, Registers::E>;
-        m_cbInstructionSet[0xF4] = &Processor::set_n_r<6, Registers::H>;
-        m_cbInstructionSet[0xF5] = &Processor::set_n_r<6, Registers::L>;
-        m_cbInstructionSet[0xF6] = &Processor::set_n_HL<6>;
-        m_cbInstructionSet[0xF7] = &Processor::set_n_r<6, Registers::A>;
-        m_cbInstructionSet[0xF8] = &Processor::set_n_r<7, Registers::B>;
-        m_cbInstructionSet[0xF9] = &Processor::set_n_r<7, Registers::C>;
-        m_cbInstructionSet[0xFA] = &Processor::set_n_r<7, Registers::D>;
-        m_cbInstructionSet[0xFB] = &Processor::set_n_r<7, Registers::E>;
-        m_cbInstructionSet[0xFC] = &Processor::set_n_r<7, Registers::H>;
-        m_cbInstructionSet[0xFD] = &Processor::set_n_r<7, Registers::L>;
-        m_cbInstructionSet[0xFE] = &Processor::set_n_HL<7>;
-        m_cbInstructionSet[0xFF] = &Processor::set_n_r<7, Registers::A>;
+#define X(opcode, ...) \
+        m_cbInstructionSet[opcode] = &Processor::__VA_ARGS__; \
+        m_cbHandlers[opcode] = &Processor::call<&Processor::__VA_ARGS__>;
+        GB_CB_OPCODES(X)
+#undef X
+    }
+
+    int Processor::execute(uint8_t opCode)
+    {
+        // Every case calls its handler directly so the compiler can inline it
+        // and emit a single jump table instead of an indirect member call.
+        switch (opCode)
+        {
+#define X(opcode, ...) case opcode: return __VA_ARGS__();
+        GB_OPCODES(X)
+#undef X
+        default:
+            return unhandled();
+        }
+    }
+
+    int Processor::executeCb(uint8_t opCode)
+    {
+        switch (opCode)
+        {
+#define X(opcode, ...) case opcode: return __VA_ARGS__();
+        GB_CB_OPCODES(X)
+#undef X
+        }
+
+        return unhandled();
     }
 
     int Processor::unhandled() 
@@ -686,6 +480,11 @@ namespace cpu
 
     uint8_t Processor::getImmediate8()
     {
+        if (m_decoded != nullptr)
+        {
+            return utils::low(m_decoded->operand);
+        }
+
         uint8_t n = m_memory.read8(m_registers.getPC());
         m_registers.incrementPC();
 
@@ -694,6 +493,11 @@ namespace cpu
 
     uint16_t Processor::getImmediate16()
     {
+        if (m_decoded != nullptr)
+        {
+            return m_decoded->operand;
+        }
+
         uint16_t nn = m_memory.read16(m_registers.getPC());
         m_registers.incrementPC();
         m_registers.incrementPC();
@@ -709,7 +513,11 @@ namespace cpu
     int Processor::cb()
     {
         uint8_t opCode = getImmediate8();
+#ifdef ANOTHERGB_THREADED_DISPATCH
+        return executeCb(opCode);
+#else
         return (this->*m_cbInstructionSet[opCode])();
+#endif
     }
 
     int Processor::ld_A_nn()
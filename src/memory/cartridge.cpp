@@ -1,43 +1,61 @@
 #include "cartridge.h"
+#include "mbc.h"
 
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <filesystem>
 
-Cartridge::Cartridge(const char* filePath)
+Cartridge::Cartridge(const char* filePath) :
+	Cartridge(RomImage::open(filePath))
 {
-	loadCartidge(filePath);
+	m_savePath = std::filesystem::path(filePath).replace_extension(".sav").string();
 }
 
-std::unique_ptr<Rom> Cartridge::buildRomFromCartridge(const Cartridge& cartridge)
+Cartridge::Cartridge(std::shared_ptr<const RomImage> image) :
+	m_image(image != nullptr ? std::move(image) : RomImage::blank())
 {
-	// TODO
-	return std::unique_ptr<Rom>();
+	parseHeader();
 }
 
-void Cartridge::loadCartidge(const char* filePath)
+std::unique_ptr<Rom> Cartridge::buildRomFromCartridge(const Cartridge& cartridge, Memory& memory)
 {
-	std::ifstream file(filePath, std::ios::binary | std::ios::ate);
-	if (!file.is_open())
+	size_t ramSize = cartridge.nbRamBank() * 0x2000;
+	std::string savePath = cartridge.hasBattery() ? cartridge.getSavePath() : "";
+	switch (cartridge.getType())
 	{
-		return;
+	case Type::MBC1:
+		return std::make_unique<Mbc1>(memory, ramSize, savePath);
+	case Type::MBC2:
+		return std::make_unique<Mbc2>(memory, savePath);
+	case Type::MBC3:
+		return std::make_unique<Mbc3>(memory, ramSize, savePath, cartridge.hasRtc());
+	case Type::MBC5:
+		return std::make_unique<Mbc5>(memory, ramSize, savePath);
+	default:
+		return std::make_unique<RomOnly>(memory, ramSize, savePath);
 	}
+}
 
-	file.seekg(0x134, std::ios::beg);
-	char buffer[15];
-	bool success = file.read(&buffer[0], 15).good();
-	if (!success)
-	{
-		return;
-	}
-	m_title = buffer;
+void Cartridge::parseHeader()
+{
+	// Blank images are all zeros, a ROM only cartridge.
+	const uint8_t* header = m_image->data();
+
+	const char* title = reinterpret_cast<const char*>(&header[0x134]);
+	m_title.assign(title, std::find(title, title + 15, '\0'));
 
-	uint8_t type = 0;
-	file.seekg(0x147, std::ios::beg);
-	success = file.read(reinterpret_cast<char*>(&type), 1).good();
-	if (!success)
+	uint8_t type = header[0x147];
+	switch (type)
 	{
-		return;
+	case 0x03: case 0x06: case 0x09: case 0x0D: case 0x0F:
+	case 0x10: case 0x13: case 0x1B: case 0x1E: case 0xFF:
+		m_hasBattery = true;
+		break;
+	default:
+		m_hasBattery = false;
+		break;
 	}
+	m_hasRtc = type == 0x0F || type == 0x10;
+
 	switch (type)
 	{
 	case 0x00:
@@ -72,23 +90,11 @@ void Cartridge::loadCartidge(const char* filePath)
 		break;
 	}
 
-	uint8_t romBank = 0;
-	file.seekg(0x148, std::ios::beg);
-	success = file.read(reinterpret_cast<char*>(&romBank), 1).good();
-	if (!success)
-	{
-		return;
-	}
-	
-	m_nbRomBank = (1 << romBank) / 16;
+	uint8_t romBank = header[0x148];
+	// 32 KiB << n
+	m_nbRomBank = 2 << romBank;
 
-	uint8_t ramBank = 0;
-	file.seekg(0x149, std::ios::beg);
-	success = file.read(reinterpret_cast<char*>(&ramBank), 1).good();
-	if (!success)
-	{
-		return;
-	}
+	uint8_t ramBank = header[0x149];
 
 	switch (ramBank)
 	{
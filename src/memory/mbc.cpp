@@ -0,0 +1,465 @@
+#include "mbc.h"
+
+#include "memory.h"
+#include "utils/frame_pacer.h"
+
+#include <algorithm>
+#include <chrono>
+
+BankedRom::BankedRom(Memory& memory, size_t ramSize, const std::string& savePath, size_t trailerSize) :
+	m_memory(memory),
+	m_ramSize(ramSize)
+{
+	if (savePath.empty() || ramSize + trailerSize == 0)
+	{
+		m_volatileRam.assign(ramSize, 0);
+		m_ram = m_volatileRam.data();
+		return;
+	}
+
+	m_save = std::make_unique<SaveFile>(savePath, ramSize + trailerSize);
+	m_ram = m_save->data();
+	m_writablePages.assign((ramSize + 0x1FFF) / 0x2000, 0);
+
+	utils::Scheduler& scheduler = m_memory.getScheduler();
+	scheduler.setHandler(utils::Event::SaveFlush, [this](uint64_t timestamp) { onFlush(timestamp); });
+	scheduler.schedule(utils::Event::SaveFlush, scheduler.now() + flushPeriod);
+}
+
+void BankedRom::mapRam(size_t bank)
+{
+	// Smaller than a bank only for MBC2, which maps nothing.
+	if (!m_ramEnabled || m_ramSize < 0x2000)
+	{
+		unmapRam();
+		return;
+	}
+
+	m_mappedBank = bank % (m_ramSize / 0x2000);
+	uint32_t writablePages = m_save != nullptr ? m_writablePages[m_mappedBank] : 0xFFFFFFFF;
+	m_memory.setRamBank(&m_ram[m_mappedBank * 0x2000], writablePages);
+}
+
+void BankedRom::unmapRam()
+{
+	m_mappedBank = unmapped;
+	m_memory.setRamBank(nullptr);
+}
+
+void BankedRom::writeRam(uint16_t addr, uint8_t val)
+{
+	// First write to a clean page of battery backed RAM.
+	if (m_mappedBank == unmapped || m_save == nullptr)
+	{
+		return;
+	}
+
+	size_t offset = m_mappedBank * 0x2000 + (addr & 0x1FFF);
+	m_ram[offset] = val;
+	markDirty(offset);
+	m_writablePages[m_mappedBank] |= 1u << ((addr >> 8) & 0x1F);
+	mapRam(m_mappedBank);
+}
+
+void BankedRom::markDirty(size_t offset)
+{
+	if (m_save != nullptr)
+	{
+		m_save->markDirty(offset);
+	}
+}
+
+void BankedRom::onFlush(uint64_t timestamp)
+{
+	saveTrailer();
+	m_save->flushAsync();
+
+	std::fill(m_writablePages.begin(), m_writablePages.end(), 0);
+	if (m_mappedBank != unmapped)
+	{
+		mapRam(m_mappedBank);
+	}
+
+	m_memory.getScheduler().schedule(utils::Event::SaveFlush, timestamp + flushPeriod);
+}
+
+void RomOnly::reset()
+{
+	m_ramEnabled = true;
+	mapRam(0);
+}
+
+void RomOnly::write(uint16_t /*addr*/, uint8_t /*val*/)
+{
+}
+
+void Mbc1::reset()
+{
+	m_ramEnabled = false;
+	m_bank1 = 1;
+	m_bank2 = 0;
+	m_advancedMode = false;
+	map();
+}
+
+void Mbc1::write(uint16_t addr, uint8_t val)
+{
+	switch (addr >> 13)
+	{
+	case 0:
+		m_ramEnabled = (val & 0x0F) == 0x0A;
+		break;
+	case 1:
+		m_bank1 = val & 0x1F;
+		if (m_bank1 == 0)
+		{
+			m_bank1 = 1;
+		}
+		break;
+	case 2:
+		m_bank2 = val & 0x03;
+		break;
+	default:
+		m_advancedMode = (val & 0x01) != 0;
+		break;
+	}
+
+	map();
+}
+
+void Mbc1::map()
+{
+	m_memory.setRomBank((m_bank2 << 5) | m_bank1);
+	m_memory.setLowRomBank(m_advancedMode ? m_bank2 << 5 : 0);
+	mapRam(m_advancedMode ? m_bank2 : 0);
+}
+
+Mbc2::Mbc2(Memory& memory, const std::string& savePath) :
+	BankedRom(memory, 0x200, savePath)
+{
+}
+
+void Mbc2::reset()
+{
+	m_ramEnabled = false;
+	m_memory.setRomBank(1);
+	m_memory.setRamBank(nullptr);
+}
+
+void Mbc2::write(uint16_t addr, uint8_t val)
+{
+	if (addr >= 0x4000)
+	{
+		return;
+	}
+
+	// Address bit 8 selects the register.
+	if ((addr & 0x0100) == 0)
+	{
+		m_ramEnabled = (val & 0x0F) == 0x0A;
+	}
+	else
+	{
+		uint8_t bank = val & 0x0F;
+		m_memory.setRomBank(bank == 0 ? 1 : bank);
+	}
+}
+
+uint8_t Mbc2::readRam(uint16_t addr)
+{
+	if (!m_ramEnabled)
+	{
+		return 0xFF;
+	}
+
+	// Only the low nibble is stored.
+	return m_ram[addr & 0x1FF] | 0xF0;
+}
+
+void Mbc2::writeRam(uint16_t addr, uint8_t val)
+{
+	if (m_ramEnabled)
+	{
+		m_ram[addr & 0x1FF] = val & 0x0F;
+		markDirty(addr & 0x1FF);
+	}
+}
+
+Mbc3::Mbc3(Memory& memory, size_t ramSize, const std::string& savePath, bool hasRtc) :
+	BankedRom(memory, ramSize, savePath, hasRtc ? rtcTrailerSize : 0),
+	m_hasRtc(hasRtc)
+{
+	m_rtcBaseCycle = m_memory.getScheduler().now();
+	loadTrailer();
+}
+
+Mbc3::~Mbc3()
+{
+	saveTrailer();
+}
+
+void Mbc3::reset()
+{
+	m_ramEnabled = false;
+	m_ramBank = 0;
+	m_memory.setRomBank(1);
+	mapRam();
+}
+
+void Mbc3::write(uint16_t addr, uint8_t val)
+{
+	switch (addr >> 13)
+	{
+	case 0:
+		m_ramEnabled = (val & 0x0F) == 0x0A;
+		mapRam();
+		break;
+	case 1:
+	{
+		uint8_t bank = val & 0x7F;
+		m_memory.setRomBank(bank == 0 ? 1 : bank);
+		break;
+	}
+	case 2:
+		m_ramBank = val;
+		mapRam();
+		break;
+	default:
+		// Writing 0 then 1 latches the clock.
+		if (m_latch == 0x00 && val == 0x01)
+		{
+			m_latchedRtc = rtcRegisters();
+		}
+		m_latch = val;
+		break;
+	}
+}
+
+void Mbc3::mapRam()
+{
+	// RTC registers go through readRam / writeRam.
+	if (m_ramBank >= 0x08)
+	{
+		unmapRam();
+		return;
+	}
+
+	BankedRom::mapRam(m_ramBank & 0x03);
+}
+
+uint8_t Mbc3::readRam(uint16_t /*addr*/)
+{
+	if (!m_ramEnabled || m_ramBank < 0x08 || m_ramBank > 0x0C)
+	{
+		return 0xFF;
+	}
+
+	return m_latchedRtc[m_ramBank - 0x08];
+}
+
+void Mbc3::writeRam(uint16_t addr, uint8_t val)
+{
+	if (m_ramBank < 0x08)
+	{
+		BankedRom::writeRam(addr, val);
+		return;
+	}
+	if (!m_ramEnabled || m_ramBank > 0x0C)
+	{
+		return;
+	}
+
+	uint64_t seconds = rtcSeconds();
+	uint64_t second = seconds % 60;
+	uint64_t minute = seconds / 60 % 60;
+	uint64_t hour = seconds / 3600 % 24;
+	uint64_t day = seconds / secondsPerDay;
+
+	switch (m_ramBank)
+	{
+	case 0x08:
+		second = val & 0x3F;
+		break;
+	case 0x09:
+		minute = val & 0x3F;
+		break;
+	case 0x0A:
+		hour = val & 0x1F;
+		break;
+	case 0x0B:
+		day = (day & 0x100) | val;
+		break;
+	default:
+		day = (day & 0xFF) | ((val & 0x01) << 8);
+		m_dayCarry = (val & 0x80) != 0;
+		break;
+	}
+
+	setRtcSeconds(((day * 24 + hour) * 60 + minute) * 60 + second);
+
+	// Stops counting at the current time, or restarts from it.
+	bool halted = (val & 0x40) != 0;
+	if (m_ramBank == 0x0C && halted != m_rtcHalted)
+	{
+		m_rtcHalted = halted;
+		m_rtcBaseCycle = m_memory.getScheduler().now();
+	}
+}
+
+uint64_t Mbc3::rtcSeconds() const
+{
+	if (m_rtcHalted)
+	{
+		return m_rtcBase;
+	}
+
+	uint64_t elapsed = m_memory.getScheduler().now() - m_rtcBaseCycle;
+	return m_rtcBase + elapsed / utils::FramePacer::clockFrequency;
+}
+
+void Mbc3::setRtcSeconds(uint64_t seconds)
+{
+	// Keeps the fraction of second already elapsed.
+	uint64_t now = m_memory.getScheduler().now();
+	uint64_t fraction = m_rtcHalted ? 0 : (now - m_rtcBaseCycle) % utils::FramePacer::clockFrequency;
+
+	m_rtcBase = seconds;
+	m_rtcBaseCycle = now - fraction;
+}
+
+std::array<uint8_t, 5> Mbc3::rtcRegisters()
+{
+	uint64_t seconds = rtcSeconds();
+	if (seconds >= maxSeconds)
+	{
+		m_dayCarry = true;
+		seconds %= maxSeconds;
+		setRtcSeconds(seconds);
+	}
+
+	uint64_t day = seconds / secondsPerDay;
+	return {
+		(uint8_t)(seconds % 60),
+		(uint8_t)(seconds / 60 % 60),
+		(uint8_t)(seconds / 3600 % 24),
+		(uint8_t)day,
+		(uint8_t)((day >> 8) | (m_rtcHalted ? 0x40 : 0) | (m_dayCarry ? 0x80 : 0))
+	};
+}
+
+namespace
+{
+uint64_t readLittleEndian(const uint8_t* data, size_t size)
+{
+	uint64_t val = 0;
+	for (size_t i = 0; i < size; i++)
+	{
+		val |= (uint64_t)data[i] << (8 * i);
+	}
+	return val;
+}
+
+void writeLittleEndian(uint8_t* data, size_t size, uint64_t val)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		data[i] = (uint8_t)(val >> (8 * i));
+	}
+}
+
+uint64_t unixTime()
+{
+	auto now = std::chrono::system_clock::now().time_since_epoch();
+	return (uint64_t)std::chrono::duration_cast<std::chrono::seconds>(now).count();
+}
+}
+
+void Mbc3::loadTrailer()
+{
+	const uint8_t* data = trailer();
+	uint64_t timestamp = data != nullptr && m_hasRtc ? readLittleEndian(data + 40, 8) : 0;
+	if (timestamp == 0)
+	{
+		// New save, or one without RTC.
+		return;
+	}
+
+	std::array<uint8_t, 5> current;
+	for (size_t i = 0; i < 5; i++)
+	{
+		current[i] = (uint8_t)readLittleEndian(data + i * 4, 4);
+		m_latchedRtc[i] = (uint8_t)readLittleEndian(data + 20 + i * 4, 4);
+	}
+
+	m_rtcHalted = (current[4] & 0x40) != 0;
+	m_dayCarry = (current[4] & 0x80) != 0;
+	uint64_t day = current[3] | ((current[4] & 0x01) << 8);
+	uint64_t seconds = ((day * 24 + current[2]) * 60 + current[1]) * 60 + current[0];
+
+	// Time spent switched off.
+	uint64_t now = unixTime();
+	if (!m_rtcHalted && now > timestamp)
+	{
+		seconds += now - timestamp;
+	}
+	m_rtcBase = seconds;
+}
+
+void Mbc3::saveTrailer()
+{
+	uint8_t* data = trailer();
+	if (data == nullptr || !m_hasRtc)
+	{
+		return;
+	}
+
+	std::array<uint8_t, 5> current = rtcRegisters();
+	for (size_t i = 0; i < 5; i++)
+	{
+		writeLittleEndian(data + i * 4, 4, current[i]);
+		writeLittleEndian(data + 20 + i * 4, 4, m_latchedRtc[i]);
+	}
+	writeLittleEndian(data + 40, 8, unixTime());
+
+	for (size_t offset = 0; offset < rtcTrailerSize; offset += SaveFile::pageSize)
+	{
+		markDirty(m_ramSize + offset);
+	}
+	markDirty(m_ramSize + rtcTrailerSize - 1);
+}
+
+void Mbc5::reset()
+{
+	m_ramEnabled = false;
+	m_romBank = 1;
+	m_ramBank = 0;
+	map();
+}
+
+void Mbc5::write(uint16_t addr, uint8_t val)
+{
+	if (addr < 0x2000)
+	{
+		m_ramEnabled = (val & 0x0F) == 0x0A;
+	}
+	else if (addr < 0x3000)
+	{
+		m_romBank = (m_romBank & 0x100) | val;
+	}
+	else if (addr < 0x4000)
+	{
+		m_romBank = (m_romBank & 0xFF) | ((val & 0x01) << 8);
+	}
+	else if (addr < 0x6000)
+	{
+		m_ramBank = val & 0x0F;
+	}
+
+	map();
+}
+
+void Mbc5::map()
+{
+	m_memory.setRomBank(m_romBank);
+	mapRam(m_ramBank);
+}
@@ -2,16 +2,42 @@
 
 #include "cartridge.h"
 #include "registery.h"
+#include "cpu/block_cache.h"
 
+#include "video/object_lines.h"
 #include "video/screen.h"
+#include "video/tile_cache.h"
 
 Memory::Memory(const Cartridge& cartridge, cpu::Registers& registers,
     video::Screen& screen,
     const char* bootROMPath):
+    m_timer(*this, m_scheduler),
     m_mmio(registers, *this, screen), 
-    m_romBank(Cartridge::buildRomFromCartridge(cartridge))
+    m_romBank(Cartridge::buildRomFromCartridge(cartridge, *this)),
+    m_rom(cartridge.getImage())
 {
     loadBootROM(bootROMPath);
+
+    mapRom();
+
+    // Video RAM, writes to tile data invalidate the tile cache. Work RAM, its
+    // echo is read only as writes must notify the block cache at the
+    // canonical address. External RAM is mapped by the cartridge.
+    mapPages(0x8000, 0x1800, &m_memoryMap[0x8000], nullptr);
+    mapPages(0x9800, 0x0800, &m_memoryMap[0x9800], &m_memoryMap[0x9800]);
+    mapPages(0xC000, 0x2000, &m_memoryMap[0xC000], &m_memoryMap[0xC000]);
+    mapPages(0xE000, 0x1E00, &m_memoryMap[0xC000], nullptr);
+
+    // OAM and the unusable area after it, writes move objects between
+    // lines. Then I/O registers and HRAM.
+    mapPages(0xFE00, 0x100, &m_memoryMap[0xFE00], nullptr);
+    mapPages(0xFF00, 0x100, nullptr, nullptr);
+
+    // LCDC as left by the boot ROM, like the Screen defaults.
+    m_memoryMap[0xFF40] = 0x91;
+
+    m_scheduler.setHandler(utils::Event::DMA, [this](uint64_t) { m_mmio.onDmaEnd(); });
+    m_scheduler.setHandler(utils::Event::Serial, [this](uint64_t) { m_mmio.onSerialEnd(); });
 }
 
 Memory::~Memory()
@@ -19,114 +45,197 @@ Memory::~Memory()
     delete[] m_bootROM;
 }
 
-void Memory::write8(uint16_t addr, uint8_t val)
+void Memory::writeSlow(uint16_t addr, uint8_t val)
 {
+    // DMA itself can be restarted from HRAM.
+    if (m_busBlocked && addr < 0xFF80 && addr != 0xFF46) [[unlikely]]
+    {
+        return;
+    }
+
     if (addr < 0x8000)
     {
-        m_memoryMap[addr] = val;
-        //return m_romBank->read(addr);
+        // Cartridge registers
+        m_romBank->write(addr, val);
     }
-    else if (addr < 0xA000)
+    else if (addr < 0x9800)
     {
-        // Video Ram
+        // Tile data
         m_memoryMap[addr] = val;
+        if (m_tileCache != nullptr)
+        {
+            m_tileCache->onWrite(addr);
+        }
     }
-    else if (addr < 0xE000)
+    else if (addr < 0xC000)
     {
-        m_memoryMap[addr] = val;
-        //return m_romBank->read(addr);
+        // External RAM without a mapped bank
+        m_romBank->writeRam(addr, val);
     }
-    else if (addr < 0xFEA0)
+    else if (addr < 0xFE00)
     {
-        // Object attribute memory
-        m_memoryMap[addr] = val;
+        // Echo of work RAM
+        write8(addr - 0x2000, val);
+    }
+    else if (addr < 0xFF00)
+    {
+        // OAM, the unusable area after it ignores writes.
+        if (addr < 0xFEA0)
+        {
+            m_memoryMap[addr] = val;
+            if (m_objectLines != nullptr)
+            {
+                m_objectLines->onWrite(addr);
+            }
+        }
     }
-    else if (addr < 0xFF80 && addr > 0xFEFF)
+    else if (addr < 0xFF80)
     {
-        // MMIO
+        // MMIO, registers store what they need themselves.
         m_mmio.write(addr, val);
     }
-    else if (addr < 0xFFFF)
+    else
     {
+        // HRAM and IE
         m_memoryMap[addr] = val;
-        //return m_romBank->read(addr);
+        if (m_blockCache != nullptr)
+        {
+            m_blockCache->onWrite(addr);
+        }
     }
-
-    m_memoryMap[addr] = val;
 }
 
-uint8_t Memory::read8(uint16_t addr)
+uint8_t Memory::readSlow(uint16_t addr)
 {
-    if (addr < 0x8000)
+    if (m_busBlocked && addr < 0xFF80) [[unlikely]]
     {
-        if (m_bootROMEnabled && addr <= 0xFF)
-        {
-            return m_bootROM[addr];
-        }
+        return 0xFF;
+    }
 
+    if (addr >= 0xFF00 && addr < 0xFF80)
+    {
+        return m_mmio.read(addr);
+    }
+    else if (addr >= 0xFF80)
+    {
         return m_memoryMap[addr];
-        //return m_romBank->read(addr);
     }
-    else if (addr < 0xA000)
+
+    // External RAM without a mapped bank
+    return m_romBank->readRam(addr);
+}
+
+void Memory::mapPages(uint16_t addr, uint16_t size, const uint8_t* read, uint8_t* write)
+{
+    auto& readPages = m_busBlocked ? m_heldReadPages : m_readPages;
+    auto& writePages = m_busBlocked ? m_heldWritePages : m_writePages;
+    for (uint16_t offset = 0; offset < size; offset += 0x100)
     {
-        // Video Ram
-        return 0;
+        size_t page = (addr + offset) >> 8;
+        readPages[page] = read != nullptr ? read + offset : nullptr;
+        writePages[page] = write != nullptr ? write + offset : nullptr;
     }
-    else if (addr < 0xE000)
+}
+
+void Memory::blockBus(bool blocked)
+{
+    if (blocked == m_busBlocked)
     {
-        return m_memoryMap[addr];
-        //return m_romBank->read(addr);
+        return;
     }
-    else if (addr < 0xFEA0)
+
+    // Every page goes through the slow path, which only lets HRAM through.
+    if (blocked)
     {
-        // Object attribute memory
-        return 0;
+        m_heldReadPages = m_readPages;
+        m_heldWritePages = m_writePages;
+        m_readPages.fill(nullptr);
+        m_writePages.fill(nullptr);
     }
-    else if (addr < 0xFF80 && addr > 0xFEFF)
+    else
     {
-        // MMIO
-        return m_mmio.read(addr);
+        m_readPages = m_heldReadPages;
+        m_writePages = m_heldWritePages;
     }
-    else if (addr < 0xFFFF)
+    m_busBlocked = blocked;
+}
+
+void Memory::mapRom()
+{
+    // Writes go to the cartridge registers.
+    setLowRomBank(0);
+    setRomBank(1);
+    setRamBank(nullptr);
+    m_romBank->reset();
+}
+
+void Memory::setRomBank(uint16_t bank)
+{
+    uint16_t previous = m_romBankNumber;
+    m_romBankNumber = (uint16_t)(bank % m_rom->nbBanks());
+    if (m_blockCache != nullptr && m_romBankNumber != previous)
     {
-        return m_memoryMap[addr];
-        //return m_romBank->read(addr);
+        m_blockCache->onBankSwitch();
     }
+    mapPages(0x4000, 0x4000, m_rom->data() + m_romBankNumber * 0x4000, nullptr);
+}
 
-    return m_memoryMap[addr];
+void Memory::setLowRomBank(uint16_t bank)
+{
+    uint16_t previous = m_lowRomBankNumber;
+    m_lowRomBankNumber = (uint16_t)(bank % m_rom->nbBanks());
+    if (m_blockCache != nullptr && m_lowRomBankNumber != previous)
+    {
+        m_blockCache->onBankSwitch();
+    }
+    mapPages(0x0000, 0x4000, m_rom->data() + m_lowRomBankNumber * 0x4000, nullptr);
+    if (m_bootROMEnabled && m_bootROM != nullptr)
+    {
+        mapPages(0x0000, 0x100, m_bootROM, nullptr);
+    }
 }
 
-void Memory::write16(uint16_t addr, uint16_t val)
+void Memory::setRamBank(uint8_t* ram, uint32_t writablePages)
 {
-    write8(addr, utils::low(val));
-    write8(addr + 1, utils::high(val));
+    mapPages(0xA000, 0x2000, ram, nullptr);
+    if (ram == nullptr)
+    {
+        return;
+    }
+
+    auto& writePages = m_busBlocked ? m_heldWritePages : m_writePages;
+    for (int page = 0; page < 0x20; page++)
+    {
+        if (writablePages & (1u << page))
+        {
+            writePages[0xA0 + page] = ram + page * 0x100;
+        }
+    }
 }
 
-uint16_t Memory::read16(uint16_t addr)
+void Memory::disableBootRom()
 {
-    return utils::to16(read8(addr + 1), read8(addr));
+    m_bootROMEnabled = false;
+    mapPages(0x0000, 0x100, m_rom->data() + m_lowRomBankNumber * 0x4000, nullptr);
 }
 
 bool Memory::loadROM(const char* filename)
 {
-    std::ifstream file(filename, std::ios::binary | std::ios::ate);
-    if (!file.is_open())
+    std::shared_ptr<const RomImage> image = RomImage::open(filename);
+    if (image == nullptr)
     {
         return false;
     }
 
-    size_t size = std::min((size_t)file.tellg(), (size_t)0x7FFF);
-    file.seekg(0, std::ios::beg);
-
-    bool readSuccess = file.read(reinterpret_cast<char*>(m_memoryMap), size).good();
-    file.close();
+    m_rom = std::move(image);
+    mapRom();
 
-    return readSuccess;
-}
+    if (m_blockCache != nullptr)
+    {
+        m_blockCache->clear();
+    }
 
-void Memory::incrementDIV()
-{
-    m_memoryMap[0xFF04] += 1;
+    return true;
 }
 
 bool Memory::loadBootROM(const char* filename)
@@ -1,9 +1,11 @@
 #include "mmio.h"
 
 #include "memory.h"
+#include "video/object_lines.h"
 #include "video/screen.h"
 
 #include <algorithm>
+#include <cstring>
 
 MMIO::MMIO(cpu::Registers& registers, Memory& memory, video::Screen& screen) :
 	m_memory(memory),
@@ -13,10 +15,14 @@ MMIO::MMIO(cpu::Registers& registers, Memory& memory, video::Screen& screen) :
 	std::fill_n(std::begin(m_mappedIOsW), 128, &MMIO::writeValue);
 	// Joypad Input
 	m_mappedIOsW[0] = &MMIO::writeValue;
+	m_mappedIOsW[0x02] = &MMIO::serialControl;
 	m_mappedIOsW[0x04] = &MMIO::resetDIV;
-	m_mappedIOsW[0x05] = &MMIO::incrementTIMA;
+	m_mappedIOsW[0x05] = &MMIO::writeTIMA;
+	m_mappedIOsW[0x06] = &MMIO::writeTMA;
+	m_mappedIOsW[0x07] = &MMIO::writeTAC;
 	
 	m_mappedIOsW[0x40] = &MMIO::lcdControl;
+	m_mappedIOsW[0x41] = &MMIO::writeSTAT;
 	m_mappedIOsW[0x42] = &MMIO::scy;
 	m_mappedIOsW[0x43] = &MMIO::scx;
 	m_mappedIOsW[0x44] = &MMIO::empty;
@@ -28,6 +34,11 @@ MMIO::MMIO(cpu::Registers& registers, Memory& memory, video::Screen& screen) :
 	m_mappedIOsW[0x50] = &MMIO::disableBootROM;
 
 	std::fill_n(std::begin(m_mappedIOsR), 128, &MMIO::readAddress);
+	m_mappedIOsR[0x04] = &MMIO::readDIV;
+	m_mappedIOsR[0x05] = &MMIO::readTIMA;
+	m_mappedIOsR[0x06] = &MMIO::readTMA;
+	m_mappedIOsR[0x07] = &MMIO::readTAC;
+	m_mappedIOsR[0x41] = &MMIO::readSTAT;
 	m_mappedIOsR[0x44] = &MMIO::ly;
 	m_mappedIOsR[0x47] = &MMIO::readBGPalette;
 }
@@ -58,25 +69,66 @@ void MMIO::writeValue(uint16_t addr, uint8_t value)
 	m_memory.m_memoryMap[addr] = value;
 }
 
-void MMIO::resetDIV(uint16_t addr, uint8_t val)
+void MMIO::serialControl(uint16_t addr, uint8_t val)
 {
-	m_memory.m_memoryMap[addr] = 0;
-}
+	m_memory.m_memoryMap[addr] = val;
 
-void MMIO::incrementTIMA(uint16_t addr, uint8_t val)
-{
-	if (m_memory.m_memoryMap[addr] == 0xFF)
+	// Transfer with the internal clock: 8 bits at 8192Hz.
+	if ((val & 0x81) == 0x81)
 	{
-		m_memory.m_memoryMap[addr] = m_memory.m_memoryMap[0xFF06];
-		// Timer interrupt
-		m_memory.m_memoryMap[0xFF0F] = m_memory.m_memoryMap[0xFF0F] | 0x04;
-	}
-	else
-	{
-		m_memory.m_memoryMap[addr] = m_memory.m_memoryMap[addr] + 1;
+		utils::Scheduler& scheduler = m_memory.m_scheduler;
+		scheduler.schedule(utils::Event::Serial, scheduler.now() + 8 * 512);
 	}
 }
 
+void MMIO::onSerialEnd()
+{
+	// No link partner, 0xFF is shifted in.
+	m_memory.m_memoryMap[0xFF01] = 0xFF;
+	m_memory.m_memoryMap[0xFF02] &= 0x7F;
+	m_memory.requestInterrupt(3);
+}
+
+void MMIO::resetDIV(uint16_t /*addr*/, uint8_t /*val*/)
+{
+	m_memory.m_timer.resetDIV();
+}
+
+void MMIO::writeTIMA(uint16_t /*addr*/, uint8_t val)
+{
+	m_memory.m_timer.writeTIMA(val);
+}
+
+void MMIO::writeTMA(uint16_t /*addr*/, uint8_t val)
+{
+	m_memory.m_timer.writeTMA(val);
+}
+
+void MMIO::writeTAC(uint16_t /*addr*/, uint8_t val)
+{
+	m_memory.m_timer.writeTAC(val);
+}
+
+uint8_t MMIO::readDIV(uint16_t /*addr*/) const
+{
+	return m_memory.m_timer.readDIV();
+}
+
+uint8_t MMIO::readTIMA(uint16_t /*addr*/) const
+{
+	return m_memory.m_timer.readTIMA();
+}
+
+uint8_t MMIO::readTMA(uint16_t /*addr*/) const
+{
+	return m_memory.m_timer.readTMA();
+}
+
+uint8_t MMIO::readTAC(uint16_t /*addr*/) const
+{
+	return m_memory.m_timer.readTAC();
+}
+
 void MMIO::lcdControl(uint16_t addr, uint8_t val)
 {
 	m_memory.m_memoryMap[addr] = val;
@@ -88,7 +140,7 @@ void MMIO::lcdControl(uint16_t addr, uint8_t val)
 
 	m_screen.enableWindow((val & 0x20) == 0x20);
 
-	uint16_t tileDataArea = ((val & 0x10) == 0x10) ? 0x8800 : 0x8800;
+	uint16_t tileDataArea = ((val & 0x10) == 0x10) ? 0x8000 : 0x8800;
 	m_screen.setTileDataArea(tileDataArea);
 
 	uint16_t bgTileMapArea = ((val & 0x08) == 0x08) ? 0x9C00 : 0x9800;
@@ -102,6 +154,16 @@ void MMIO::lcdControl(uint16_t addr, uint8_t val)
 	m_screen.enablePriority((val & 0x01) == 0x01);
 }
 
+void MMIO::writeSTAT(uint16_t /*addr*/, uint8_t val)
+{
+	m_screen.setSTAT(val);
+}
+
+uint8_t MMIO::readSTAT(uint16_t /*addr*/) const
+{
+	return m_screen.getSTAT();
+}
+
 void MMIO::scy(uint16_t addr, uint8_t val)
 {
 	m_memory.m_memoryMap[addr] = val > 255 ? val % 255 : val;
@@ -122,23 +184,57 @@ void MMIO::lyc(uint16_t addr, uint8_t val)
 
 void MMIO::wy(uint16_t addr, uint8_t val)
 {
-	m_memory.m_memoryMap[addr] = val > 143 ? val % 143 : val;
-	m_screen.setWY(m_memory.m_memoryMap[addr]);
+	m_memory.m_memoryMap[addr] = val;
+	m_screen.setWY(val);
 }
 
 void MMIO::wx(uint16_t addr, uint8_t val)
 {
-	m_memory.m_memoryMap[addr] = val > 166 ? val % 166 : val;
-	m_screen.setWX(m_memory.m_memoryMap[addr]);
+	m_memory.m_memoryMap[addr] = val;
+	m_screen.setWX(val);
 }
 
-void MMIO::dma(uint16_t /*addr*/, uint8_t val)
+void MMIO::dma(uint16_t addr, uint8_t val)
 {
-	uint16_t srcAddr = val * 100;
-	for (int i = 0; i <= 0x9F; i++)
+	m_memory.m_memoryMap[addr] = val;
+
+	// A transfer restarted before the previous one ended reads the source
+	// through the mapping held meanwhile, not the blocked bus.
+	m_memory.blockBus(false);
+
+	// Above 0xDF the source is the work RAM echo.
+	uint8_t srcPage = val >= 0xE0 ? val - 0x20 : val;
+	uint8_t* oam = &m_memory.m_memoryMap[0xFE00];
+	if (const uint8_t* src = m_memory.m_readPages[srcPage])
 	{
-		m_memory.m_memoryMap[0xFE00 + i] = m_memory.m_memoryMap[srcAddr + i];
+		std::memcpy(oam, src, 0xA0);
 	}
+	else
+	{
+		// External RAM without a mapped bank
+		for (int i = 0; i < 0xA0; i++)
+		{
+			oam[i] = m_memory.readSlow((uint16_t)(srcPage << 8 | i));
+		}
+	}
+
+	if (m_memory.m_objectLines != nullptr)
+	{
+		m_memory.m_objectLines->rebuild();
+	}
+
+	// The copy is done at once, the transfer still lasts 160 M-cycles during
+	// which the CPU only reaches HRAM.
+	m_dmaActive = true;
+	m_memory.blockBus(true);
+	utils::Scheduler& scheduler = m_memory.m_scheduler;
+	scheduler.schedule(utils::Event::DMA, scheduler.now() + 160 * 4);
+}
+
+void MMIO::onDmaEnd()
+{
+	m_dmaActive = false;
+	m_memory.blockBus(false);
 }
 
 void MMIO::updateBGPalette(uint16_t addr, uint8_t val)
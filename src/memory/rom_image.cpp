@@ -0,0 +1,193 @@
+#include "rom_image.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <mutex>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+struct OpenImage
+{
+	std::weak_ptr<const RomImage> image;
+	std::filesystem::file_time_type writeTime;
+	uintmax_t size = 0;
+};
+
+std::mutex openImagesMutex;
+std::map<std::filesystem::path, OpenImage> openImages;
+
+bool isWholeBanks(size_t size)
+{
+	return size >= 0x8000 && size % 0x4000 == 0;
+}
+}
+
+std::shared_ptr<const RomImage> RomImage::open(const char* filePath)
+{
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::canonical(filePath, error);
+	if (error)
+	{
+		return nullptr;
+	}
+	std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(path, error);
+	uintmax_t size = std::filesystem::file_size(path, error);
+	if (error)
+	{
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(openImagesMutex);
+
+	OpenImage& entry = openImages[path];
+	std::shared_ptr<const RomImage> image = entry.image.lock();
+	if (image != nullptr && entry.writeTime == writeTime && entry.size == size)
+	{
+		return image;
+	}
+
+	std::shared_ptr<RomImage> mapped(new RomImage());
+	if (!mapped->map(path.string().c_str()))
+	{
+		return nullptr;
+	}
+
+	entry = { mapped, writeTime, size };
+	return mapped;
+}
+
+std::shared_ptr<const RomImage> RomImage::blank()
+{
+	static std::shared_ptr<const RomImage> image = []()
+	{
+		std::shared_ptr<RomImage> blank(new RomImage());
+		blank->copy(nullptr, 0);
+		return blank;
+	}();
+
+	return image;
+}
+
+RomImage::~RomImage()
+{
+	if (m_mapping == nullptr)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_mapping);
+#else
+	munmap(m_mapping, m_mappingSize);
+#endif
+}
+
+#ifdef _WIN32
+bool RomImage::map(const char* filePath)
+{
+	HANDLE file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	GetFileSizeEx(file, &fileSize);
+	size_t size = (size_t)fileSize.QuadPart;
+
+	HANDLE mapping = size > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (mapping != nullptr)
+	{
+		CloseHandle(mapping);
+	}
+	CloseHandle(file);
+
+	if (view == nullptr)
+	{
+		if (size != 0)
+		{
+			return false;
+		}
+		copy(nullptr, 0);
+		return true;
+	}
+
+	if (!isWholeBanks(size))
+	{
+		copy(static_cast<const uint8_t*>(view), size);
+		UnmapViewOfFile(view);
+		return true;
+	}
+
+	m_mapping = view;
+	m_mappingSize = size;
+	m_data = static_cast<const uint8_t*>(view);
+	m_size = size;
+	return true;
+}
+#else
+bool RomImage::map(const char* filePath)
+{
+	int fd = ::open(filePath, O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat info = {};
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		return false;
+	}
+	size_t size = (size_t)info.st_size;
+
+	void* view = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+	close(fd);
+
+	if (view == MAP_FAILED)
+	{
+		if (size != 0)
+		{
+			return false;
+		}
+		copy(nullptr, 0);
+		return true;
+	}
+
+	if (!isWholeBanks(size))
+	{
+		copy(static_cast<const uint8_t*>(view), size);
+		munmap(view, size);
+		return true;
+	}
+
+	m_mapping = view;
+	m_mappingSize = size;
+	m_data = static_cast<const uint8_t*>(view);
+	m_size = size;
+	return true;
+}
+#endif
+
+void RomImage::copy(const uint8_t* data, size_t size)
+{
+	// Whole banks, at least two of them.
+	m_copy.assign(std::max<size_t>((size + 0x3FFF) & ~(size_t)0x3FFF, 0x8000), 0);
+	std::copy(data, data + size, m_copy.begin());
+
+	m_data = m_copy.data();
+	m_size = m_copy.size();
+}
@@ -0,0 +1,236 @@
+#include "save_file.h"
+
+#include <algorithm>
+#include <fstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SaveFile::SaveFile(const std::string& path, size_t size) :
+	m_size(size),
+	m_dirty((size + pageSize - 1) / pageSize, false),
+	m_pending(m_dirty.size(), false)
+{
+	if (!map(path))
+	{
+		m_fallback.assign(size, 0);
+		m_data = m_fallback.data();
+		loadCopy(path);
+		return;
+	}
+
+	m_thread = std::thread(&SaveFile::run, this);
+}
+
+SaveFile::~SaveFile()
+{
+	if (m_thread.joinable())
+	{
+		flush();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_wakeUp.notify_one();
+		m_thread.join();
+	}
+
+	unmap();
+}
+
+void SaveFile::flushAsync()
+{
+	if (!isMapped() || std::find(m_dirty.begin(), m_dirty.end(), true) == m_dirty.end())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t page = 0; page < m_dirty.size(); page++)
+		{
+			if (m_dirty[page])
+			{
+				m_pending[page] = true;
+			}
+		}
+		m_hasPending = true;
+	}
+	std::fill(m_dirty.begin(), m_dirty.end(), false);
+
+	m_wakeUp.notify_one();
+}
+
+void SaveFile::flush()
+{
+	flushAsync();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_synced.wait(lock, [this]() { return !m_hasPending && !m_syncing; });
+}
+
+void SaveFile::loadCopy(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	file.read(reinterpret_cast<char*>(m_fallback.data()), m_fallback.size());
+}
+
+void SaveFile::run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_wakeUp.wait(lock, [this]() { return m_hasPending || m_stop; });
+		if (!m_hasPending)
+		{
+			return;
+		}
+
+		std::vector<bool> pages(m_pending.size(), false);
+		pages.swap(m_pending);
+		m_hasPending = false;
+		m_syncing = true;
+
+		lock.unlock();
+		sync(pages);
+		lock.lock();
+
+		m_syncing = false;
+		m_synced.notify_all();
+	}
+}
+
+#ifdef _WIN32
+bool SaveFile::map(const std::string& path)
+{
+	// Denying write sharing locks the file while the handle stays open.
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	// Keeps longer files (RTC footer) whole, extends shorter ones with zeros.
+	LARGE_INTEGER fileSize = {};
+	GetFileSizeEx(file, &fileSize);
+	size_t mappingSize = std::max((size_t)fileSize.QuadPart, m_size);
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)mappingSize >> 32), (DWORD)mappingSize, nullptr);
+	void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0) : nullptr;
+	if (mapping != nullptr)
+	{
+		CloseHandle(mapping);
+	}
+
+	if (view == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = view;
+	m_mappingSize = mappingSize;
+	m_data = static_cast<uint8_t*>(view);
+	return true;
+}
+
+void SaveFile::unmap()
+{
+	if (m_mapping != nullptr)
+	{
+		UnmapViewOfFile(m_mapping);
+		CloseHandle(m_file);
+	}
+}
+
+void SaveFile::sync(const std::vector<bool>& pages)
+{
+	for (size_t page = 0; page < pages.size(); page++)
+	{
+		if (pages[page])
+		{
+			FlushViewOfFile(m_data + page * pageSize, pageSize);
+		}
+	}
+}
+#else
+bool SaveFile::map(const std::string& path)
+{
+	int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	// flock locks conflict between open files, even within a process.
+	if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	// Keeps longer files (RTC footer) whole, extends shorter ones with zeros.
+	struct stat info = {};
+	if (fstat(fd, &info) != 0 || ((size_t)info.st_size < m_size && ftruncate(fd, m_size) != 0))
+	{
+		close(fd);
+		return false;
+	}
+	size_t mappingSize = std::max((size_t)info.st_size, m_size);
+
+	void* view = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (view == MAP_FAILED)
+	{
+		close(fd);
+		return false;
+	}
+
+	m_fd = fd;
+	m_mapping = view;
+	m_mappingSize = mappingSize;
+	m_data = static_cast<uint8_t*>(view);
+	return true;
+}
+
+void SaveFile::unmap()
+{
+	if (m_mapping != nullptr)
+	{
+		munmap(m_mapping, m_mappingSize);
+		close(m_fd);
+	}
+}
+
+void SaveFile::sync(const std::vector<bool>& pages)
+{
+	// msync works on whole OS pages.
+	uintptr_t osPageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+	uintptr_t base = (uintptr_t)m_data;
+	uintptr_t synced = 0;
+	for (size_t page = 0; page < pages.size(); page++)
+	{
+		if (!pages[page])
+		{
+			continue;
+		}
+
+		uintptr_t start = (base + page * pageSize) & ~(osPageSize - 1);
+		if (start < synced)
+		{
+			continue;
+		}
+		uintptr_t end = std::min(start + osPageSize, base + m_mappingSize);
+		msync(reinterpret_cast<void*>(start), end - start, MS_SYNC);
+		synced = start + osPageSize;
+	}
+}
+#endif
@@ -0,0 +1,95 @@
+#include "timer.h"
+
+#include "memory.h"
+#include "utils/scheduler.h"
+
+Timer::Timer(Memory& memory, utils::Scheduler& scheduler) :
+    m_memory(memory),
+    m_scheduler(scheduler)
+{
+    m_scheduler.setHandler(utils::Event::Timer, [this](uint64_t timestamp) { onOverflow(timestamp); });
+}
+
+uint8_t Timer::readDIV() const
+{
+    // Incremented at 16384Hz, every 256 T-cycles.
+    return (uint8_t)((m_scheduler.now() - m_divReset) >> 8);
+}
+
+void Timer::resetDIV()
+{
+    snapshot();
+    m_divReset = m_scheduler.now();
+    scheduleOverflow();
+}
+
+uint8_t Timer::readTIMA() const
+{
+    if (!isEnabled())
+    {
+        return m_tima;
+    }
+
+    return (uint8_t)(m_tima + ticksAt(m_scheduler.now()) - ticksAt(m_timaTime));
+}
+
+void Timer::writeTIMA(uint8_t val)
+{
+    m_tima = val;
+    m_timaTime = m_scheduler.now();
+    scheduleOverflow();
+}
+
+void Timer::writeTAC(uint8_t val)
+{
+    snapshot();
+    m_tac = val & 0x07;
+    scheduleOverflow();
+}
+
+uint64_t Timer::period() const
+{
+    switch (m_tac & 0x03)
+    {
+    case 0x00:
+        return 1024;
+    case 0x01:
+        return 16;
+    case 0x02:
+        return 64;
+    default:
+        return 256;
+    }
+}
+
+uint64_t Timer::ticksAt(uint64_t time) const
+{
+    return (time - m_divReset) / period();
+}
+
+void Timer::snapshot()
+{
+    m_tima = readTIMA();
+    m_timaTime = m_scheduler.now();
+}
+
+void Timer::scheduleOverflow()
+{
+    if (!isEnabled())
+    {
+        m_scheduler.cancel(utils::Event::Timer);
+        return;
+    }
+
+    uint64_t overflowTick = ticksAt(m_timaTime) + (0x100 - m_tima);
+    m_scheduler.schedule(utils::Event::Timer, m_divReset + overflowTick * period());
+}
+
+void Timer::onOverflow(uint64_t timestamp)
+{
+    m_tima = m_tma;
+    m_timaTime = timestamp;
+    m_memory.requestInterrupt(2);
+
+    scheduleOverflow();
+}
@@ -0,0 +1,56 @@
+#include "utils/frame_pacer.h"
+
+#include <thread>
+
+namespace utils
+{
+FramePacer::FramePacer(double speed) :
+    m_speed(speed)
+{
+    resync(Clock::now());
+    m_windowStart = m_deadline;
+}
+
+void FramePacer::setSpeed(double speed)
+{
+    m_speed = speed;
+    resync(Clock::now());
+}
+
+void FramePacer::endFrame(uint64_t cycles)
+{
+    Clock::time_point now = Clock::now();
+
+    m_windowCycles += cycles;
+    std::chrono::duration<double> window = now - m_windowStart;
+    if (window >= std::chrono::seconds(1))
+    {
+        m_measuredSpeed = m_windowCycles / (window.count() * clockFrequency);
+        m_windowStart = now;
+        m_windowCycles = 0;
+    }
+
+    if (m_speed <= unthrottled)
+    {
+        return;
+    }
+
+    m_deadline += std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(cycles / (clockFrequency * m_speed)));
+
+    if (now > m_deadline + maxLag)
+    {
+        // Too slow or stopped in a debugger, running frames back to back
+        // would only make it worse.
+        resync(now);
+        return;
+    }
+
+    std::this_thread::sleep_until(m_deadline);
+}
+
+void FramePacer::resync(Clock::time_point now)
+{
+    m_deadline = now;
+}
+}
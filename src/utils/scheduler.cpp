@@ -0,0 +1,121 @@
+#include "utils/scheduler.h"
+
+#include <utility>
+
+namespace utils
+{
+Scheduler::Scheduler()
+{
+    m_positions.fill(-1);
+}
+
+void Scheduler::setHandler(Event event, Handler handler)
+{
+    m_handlers[(size_t)event] = std::move(handler);
+}
+
+void Scheduler::schedule(Event event, uint64_t timestamp)
+{
+    size_t id = (size_t)event;
+    m_timestamps[id] = timestamp;
+
+    if (m_positions[id] < 0)
+    {
+        m_heap[m_size] = event;
+        m_positions[id] = (int)m_size;
+        m_size++;
+        siftUp(m_size - 1);
+    }
+    else
+    {
+        siftUp(m_positions[id]);
+        siftDown(m_positions[id]);
+    }
+
+    m_next = timestampAt(0);
+}
+
+void Scheduler::cancel(Event event)
+{
+    int position = m_positions[(size_t)event];
+    if (position < 0)
+    {
+        return;
+    }
+
+    remove(position);
+    m_next = m_size > 0 ? timestampAt(0) : never;
+}
+
+void Scheduler::runDue()
+{
+    while (m_size > 0 && timestampAt(0) <= m_now)
+    {
+        Event event = m_heap[0];
+        uint64_t timestamp = timestampAt(0);
+        remove(0);
+
+        // The handler may schedule the event again.
+        m_handlers[(size_t)event](timestamp);
+    }
+    m_next = m_size > 0 ? timestampAt(0) : never;
+}
+
+void Scheduler::siftUp(size_t index)
+{
+    while (index > 0)
+    {
+        size_t parent = (index - 1) / 2;
+        if (timestampAt(parent) <= timestampAt(index))
+        {
+            break;
+        }
+        swap(parent, index);
+        index = parent;
+    }
+}
+
+void Scheduler::siftDown(size_t index)
+{
+    while (true)
+    {
+        size_t smallest = index;
+        size_t left = 2 * index + 1;
+        size_t right = left + 1;
+        if (left < m_size && timestampAt(left) < timestampAt(smallest))
+        {
+            smallest = left;
+        }
+        if (right < m_size && timestampAt(right) < timestampAt(smallest))
+        {
+            smallest = right;
+        }
+        if (smallest == index)
+        {
+            break;
+        }
+        swap(smallest, index);
+        index = smallest;
+    }
+}
+
+void Scheduler::swap(size_t a, size_t b)
+{
+    std::swap(m_heap[a], m_heap[b]);
+    m_positions[(size_t)m_heap[a]] = (int)a;
+    m_positions[(size_t)m_heap[b]] = (int)b;
+}
+
+void Scheduler::remove(size_t index)
+{
+    Event event = m_heap[index];
+    m_size--;
+    if (index != m_size)
+    {
+        swap(index, m_size);
+        siftUp(index);
+        siftDown(index);
+    }
+    m_positions[(size_t)event] = -1;
+}
+}
@@ -0,0 +1,35 @@
+#include "video/frame_exchange.h"
+
+namespace video
+{
+FrameExchange::FrameExchange(size_t frameSize)
+{
+	for (auto& buffer : m_buffers)
+	{
+		buffer.reset(new uint8_t[frameSize]());
+	}
+}
+
+uint8_t* FrameExchange::publish()
+{
+	m_numbers[m_back] = m_published.load(std::memory_order_relaxed) + 1;
+
+	// Release the frame, acquire the one the consumer last read.
+	uint8_t previous = m_middle.exchange(m_back | newFrameBit, std::memory_order_acq_rel);
+	m_back = previous & indexMask;
+	m_published.fetch_add(1, std::memory_order_relaxed);
+
+	return getBackBuffer();
+}
+
+const uint8_t* FrameExchange::acquire()
+{
+	if (hasNewFrame())
+	{
+		uint8_t previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+		m_front = previous & indexMask;
+	}
+
+	return m_buffers[m_front].get();
+}
+}
@@ -0,0 +1,85 @@
+#include "video/object_lines.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace video
+{
+void ObjectLines::setOam(const uint8_t* oam)
+{
+	m_oam = oam;
+	rebuild();
+}
+
+void ObjectLines::setObjectHeight(uint8_t height)
+{
+	if (height != m_height)
+	{
+		m_height = height;
+		rebuild();
+	}
+}
+
+void ObjectLines::rebuild()
+{
+	std::fill_n(m_lineMasks, nbLines, 0);
+	if (m_oam == nullptr)
+	{
+		return;
+	}
+
+	for (int object = 0; object < nbObjects; object++)
+	{
+		m_tops[object] = m_oam[object * 4] - 16;
+		setLines(object, true);
+	}
+}
+
+void ObjectLines::move(int object)
+{
+	setLines(object, false);
+	m_tops[object] = m_oam[object * 4] - 16;
+	setLines(object, true);
+}
+
+void ObjectLines::setLines(int object, bool covered)
+{
+	int first = std::max(m_tops[object], 0);
+	int last = std::min(m_tops[object] + m_height, nbLines);
+	uint64_t bit = 1ull << object;
+	for (int line = first; line < last; line++)
+	{
+		m_lineMasks[line] = covered ? m_lineMasks[line] | bit : m_lineMasks[line] & ~bit;
+	}
+}
+
+int ObjectLines::select(uint8_t line, uint8_t (&objects)[maxObjectsPerLine]) const
+{
+	if (line >= nbLines)
+	{
+		return 0;
+	}
+
+	// Lowest bits first is OAM order.
+	int count = 0;
+	for (uint64_t mask = m_lineMasks[line]; mask != 0 && count < maxObjectsPerLine; mask &= mask - 1)
+	{
+		objects[count++] = (uint8_t)std::countr_zero(mask);
+	}
+
+	// Lower X first, OAM order breaks ties. Insertion sort is stable and
+	// doesn't allocate like std::stable_sort.
+	for (int i = 1; i < count; i++)
+	{
+		uint8_t object = objects[i];
+		int j = i;
+		for (; j > 0 && m_oam[objects[j - 1] * 4 + 1] > m_oam[object * 4 + 1]; j--)
+		{
+			objects[j] = objects[j - 1];
+		}
+		objects[j] = object;
+	}
+
+	return count;
+}
+}
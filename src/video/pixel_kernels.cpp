@@ -0,0 +1,226 @@
+#include "video/pixel_kernels.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ANOTHERGB_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(ANOTHERGB_X86) && defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace video
+{
+namespace
+{
+void decodeTileScalar(const uint8_t* data, uint8_t* colorIds)
+{
+	// The multiply spreads bit 7 - i of a byte to the top of byte i.
+	for (int y = 0; y < 8; y++)
+	{
+		uint64_t low = ((data[y * 2] * 0x8040201008040201) & 0x8080808080808080) >> 7;
+		uint64_t high = ((data[y * 2 + 1] * 0x8040201008040201) & 0x8080808080808080) >> 6;
+
+		uint64_t row = low | high;
+		std::memcpy(colorIds + y * 8, &row, 8);
+	}
+}
+
+void lookupScalar(const uint8_t* indices, const uint8_t* lut, uint8_t* out, int count)
+{
+	for (int x = 0; x < count; x++)
+	{
+		out[x] = lut[indices[x]];
+	}
+}
+
+void toRgbaScalar(const uint8_t* indices, const uint8_t* lut, uint8_t* rgba, int count)
+{
+	for (int x = 0; x < count; x++, rgba += 4)
+	{
+		uint8_t color = lut[indices[x]];
+		rgba[0] = color;
+		rgba[1] = color;
+		rgba[2] = color;
+		rgba[3] = 255;
+	}
+}
+
+const PixelKernels scalarKernels = { "scalar", &decodeTileScalar, &lookupScalar, &toRgbaScalar };
+
+#ifdef ANOTHERGB_X86
+// Repeats each of the 8 low bytes of v 8 times, two rows per vector.
+void spreadRows(__m128i v, __m128i (&rows)[4])
+{
+	__m128i pairs = _mm_unpacklo_epi8(v, v);
+	__m128i quads = _mm_unpacklo_epi16(pairs, pairs);
+	rows[0] = _mm_unpacklo_epi32(quads, quads);
+	rows[1] = _mm_unpackhi_epi32(quads, quads);
+	quads = _mm_unpackhi_epi16(pairs, pairs);
+	rows[2] = _mm_unpacklo_epi32(quads, quads);
+	rows[3] = _mm_unpackhi_epi32(quads, quads);
+}
+
+void decodeTileSse2(const uint8_t* data, uint8_t* colorIds)
+{
+	// Bit of each pixel, leftmost first.
+	const __m128i bits = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+
+	__m128i tile = _mm_loadu_si128((const __m128i*)data);
+	__m128i lows = _mm_packus_epi16(_mm_and_si128(tile, _mm_set1_epi16(0xFF)), _mm_setzero_si128());
+	__m128i highs = _mm_packus_epi16(_mm_srli_epi16(tile, 8), _mm_setzero_si128());
+
+	__m128i lowRows[4];
+	__m128i highRows[4];
+	spreadRows(lows, lowRows);
+	spreadRows(highs, highRows);
+	for (int i = 0; i < 4; i++)
+	{
+		__m128i low = _mm_cmpeq_epi8(_mm_and_si128(lowRows[i], bits), bits);
+		__m128i high = _mm_cmpeq_epi8(_mm_and_si128(highRows[i], bits), bits);
+		__m128i ids = _mm_or_si128(_mm_and_si128(low, _mm_set1_epi8(1)), _mm_and_si128(high, _mm_set1_epi8(2)));
+		_mm_storeu_si128((__m128i*)(colorIds + i * 16), ids);
+	}
+}
+
+// Gray to RGBA: g g g 255.
+void storeRgbaSse2(__m128i gray, uint8_t* rgba)
+{
+	const __m128i alpha = _mm_set1_epi8(-1);
+
+	__m128i gg = _mm_unpacklo_epi8(gray, gray);
+	__m128i ga = _mm_unpacklo_epi8(gray, alpha);
+	_mm_storeu_si128((__m128i*)rgba, _mm_unpacklo_epi16(gg, ga));
+	_mm_storeu_si128((__m128i*)(rgba + 16), _mm_unpackhi_epi16(gg, ga));
+
+	gg = _mm_unpackhi_epi8(gray, gray);
+	ga = _mm_unpackhi_epi8(gray, alpha);
+	_mm_storeu_si128((__m128i*)(rgba + 32), _mm_unpacklo_epi16(gg, ga));
+	_mm_storeu_si128((__m128i*)(rgba + 48), _mm_unpackhi_epi16(gg, ga));
+}
+
+// No byte shuffle before SSSE3, the lookup selects each entry in turn.
+__m128i lookupSse2(__m128i index, const __m128i (&entries)[16])
+{
+	__m128i result = _mm_setzero_si128();
+	for (int i = 0; i < 16; i++)
+	{
+		__m128i match = _mm_cmpeq_epi8(index, _mm_set1_epi8((char)i));
+		result = _mm_or_si128(result, _mm_and_si128(match, entries[i]));
+	}
+	return result;
+}
+
+void lookupSse2(const uint8_t* indices, const uint8_t* lut, uint8_t* out, int count)
+{
+	__m128i entries[16];
+	for (int i = 0; i < 16; i++)
+	{
+		entries[i] = _mm_set1_epi8((char)lut[i]);
+	}
+
+	for (int x = 0; x < count; x += 16)
+	{
+		__m128i index = _mm_loadu_si128((const __m128i*)(indices + x));
+		_mm_storeu_si128((__m128i*)(out + x), lookupSse2(index, entries));
+	}
+}
+
+void toRgbaSse2(const uint8_t* indices, const uint8_t* lut, uint8_t* rgba, int count)
+{
+	__m128i entries[16];
+	for (int i = 0; i < 16; i++)
+	{
+		entries[i] = _mm_set1_epi8((char)lut[i]);
+	}
+
+	for (int x = 0; x < count; x += 16, rgba += 64)
+	{
+		__m128i index = _mm_loadu_si128((const __m128i*)(indices + x));
+		storeRgbaSse2(lookupSse2(index, entries), rgba);
+	}
+}
+
+TARGET_AVX2 void lookupAvx2(const uint8_t* indices, const uint8_t* lut, uint8_t* out, int count)
+{
+	const __m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)lut));
+	for (int x = 0; x < count; x += 32)
+	{
+		__m256i index = _mm256_loadu_si256((const __m256i*)(indices + x));
+		_mm256_storeu_si256((__m256i*)(out + x), _mm256_shuffle_epi8(table, index));
+	}
+}
+
+TARGET_AVX2 void toRgbaAvx2(const uint8_t* indices, const uint8_t* lut, uint8_t* rgba, int count)
+{
+	const __m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)lut));
+	const __m256i alpha = _mm256_set1_epi8(-1);
+
+	for (int x = 0; x < count; x += 32, rgba += 128)
+	{
+		__m256i gray = _mm256_shuffle_epi8(table, _mm256_loadu_si256((const __m256i*)(indices + x)));
+
+		// Unpacks work within 128-bit lanes, a holds pixels 0-3 | 16-19, b
+		// 4-7 | 20-23, c 8-11 | 24-27 and d 12-15 | 28-31.
+		__m256i gg = _mm256_unpacklo_epi8(gray, gray);
+		__m256i ga = _mm256_unpacklo_epi8(gray, alpha);
+		__m256i a = _mm256_unpacklo_epi16(gg, ga);
+		__m256i b = _mm256_unpackhi_epi16(gg, ga);
+		gg = _mm256_unpackhi_epi8(gray, gray);
+		ga = _mm256_unpackhi_epi8(gray, alpha);
+		__m256i c = _mm256_unpacklo_epi16(gg, ga);
+		__m256i d = _mm256_unpackhi_epi16(gg, ga);
+
+		_mm256_storeu_si256((__m256i*)rgba, _mm256_permute2x128_si256(a, b, 0x20));
+		_mm256_storeu_si256((__m256i*)(rgba + 32), _mm256_permute2x128_si256(c, d, 0x20));
+		_mm256_storeu_si256((__m256i*)(rgba + 64), _mm256_permute2x128_si256(a, b, 0x31));
+		_mm256_storeu_si256((__m256i*)(rgba + 96), _mm256_permute2x128_si256(c, d, 0x31));
+	}
+}
+
+bool hasAvx2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+	return osSavesAvx && (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+// Tiles are decoded rarely thanks to the cache, 128-bit is enough there.
+const PixelKernels sse2Kernels = { "sse2", &decodeTileSse2, &lookupSse2, &toRgbaSse2 };
+const PixelKernels avx2Kernels = { "avx2", &decodeTileSse2, &lookupAvx2, &toRgbaAvx2 };
+#endif
+}
+
+const PixelKernels& PixelKernels::best()
+{
+	static const PixelKernels& kernels = *available().back();
+	return kernels;
+}
+
+std::vector<const PixelKernels*> PixelKernels::available()
+{
+	std::vector<const PixelKernels*> kernels = { &scalarKernels };
+#ifdef ANOTHERGB_X86
+	// SSE2 is part of x86-64.
+	kernels.push_back(&sse2Kernels);
+	if (hasAvx2())
+	{
+		kernels.push_back(&avx2Kernels);
+	}
+#endif
+	return kernels;
+}
+}
@@ -1,71 +1,182 @@
 #include "video/screen.h"
 
 #include "memory/memory.h"
+#include "utils/scheduler.h"
 #include "utils/utils.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace video
 {
-Screen::Screen()
-	: m_frameBuffer(new uint8_t[SCREEN_WIDTH * SCREEN_HEIGHT * 4]())
+namespace
 {
-	for (int i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT * 4; i++)
-	{
-		m_frameBuffer[i] = 255;
-	}
+// Folds a value into a line fingerprint.
+uint64_t mix(uint64_t hash, uint64_t value)
+{
+	hash = (hash ^ value) * 0x9E3779B97F4A7C15;
+	return hash ^ (hash >> 32);
+}
 }
 
-Screen::~Screen()
+Screen::Screen()
+	: m_frames(SCREEN_WIDTH * SCREEN_HEIGHT),
+	m_frameBuffer(m_frames.getBackBuffer()),
+	m_kernels(PixelKernels::best())
 {
-	delete[] m_frameBuffer;
 }
+
+Screen::~Screen() = default;
 	
-void Screen::tick(uint8_t count)
+void Screen::setMemory(Memory* memory)
 {
-	updateStatusRegister();
+	m_memory = memory;
+	m_tileCache.setVideoRam(m_memory->getVideoRam());
+	m_memory->setTileCache(&m_tileCache);
+	m_objectLines.setOam(m_memory->getOam());
+	m_memory->setObjectLines(&m_objectLines);
 
+	utils::Scheduler& scheduler = m_memory->getScheduler();
+	scheduler.setHandler(utils::Event::PPU, [this](uint64_t timestamp) { onModeEnd(timestamp); });
 	if (m_lcdEnabled)
 	{
-		m_scanlineCounter += count;
-	}
-	else
-	{
-		return;
+		startLCD(scheduler.now());
 	}
+}
+
+void Screen::startLCD(uint64_t now)
+{
+	m_ly = 0;
+	m_lineStart = now;
+	startFrame();
+	enterMode(2);
+	m_memory->getScheduler().schedule(utils::Event::PPU, m_lineStart + 80);
+}
 
-	if (m_scanlineCounter >= 456)
+void Screen::onModeEnd(uint64_t /*timestamp*/)
+{
+	uint64_t next = 0;
+	switch (m_mode)
 	{
+	case 2:
+		enterMode(3);
+		next = m_lineStart + 80 + 172;
+		break;
+	case 3:
+		// The window shows from the first line where LY matches WY until the
+		// end of the frame. Its line counter only moves on lines it is drawn,
+		// drawn frames or not.
+		m_windowTriggered = m_windowTriggered || m_ly == m_wy;
+		m_windowVisible = m_windowEnabled && m_windowTriggered && m_wx <= 166;
+		if (m_renderFrame)
+		{
+			renderLine(m_ly);
+		}
+		if (m_windowVisible)
+		{
+			m_windowLine++;
+		}
+		enterMode(0);
+		next = m_lineStart + 456;
+		break;
+	default:
+		// End of line
+		m_lineStart += 456;
 		m_ly++;
-		m_scanlineCounter = 0;
 
 		if (m_ly == 144)
 		{
-			// Entering VBlank
-			uint8_t if_flag = m_memory->read8(0xFF0F);
-			if_flag = utils::setBit(if_flag, 0);
-			m_memory->write8(0xFF0F, if_flag);
+			// Entering VBlank, the frame is complete.
+			if (m_renderFrame)
+			{
+				m_frameBuffer = m_frames.publish();
+			}
+			m_frameCount++;
+			m_memory->requestInterrupt(0);
+			m_mode = 1;
 		}
 		else if (m_ly > 153)
 		{
 			m_ly = 0;
+			m_mode = 2;
+			startFrame();
 		}
 		else if (m_ly < 144)
 		{
-			// Render ScanLine ?
-			renderBG(m_ly);
+			m_mode = 2;
 		}
+		updateStatInterrupt();
+
+		next = m_lineStart + (m_mode == 2 ? 80 : 456);
+		break;
 	}
+
+	m_memory->getScheduler().schedule(utils::Event::PPU, next);
 }
 
-void Screen::setMemory(Memory* memory)
+void Screen::startFrame()
 {
-	m_memory = memory;
+	m_windowTriggered = false;
+	m_windowLine = 0;
+	m_renderFrame = m_frameCount == m_requestedFrame
+		|| (m_renderInterval != 0 && m_frameCount % m_renderInterval == 0);
 }
 
-uint8_t* Screen::getFrameBuffer()
+void Screen::setRenderInterval(uint32_t interval)
+{
+	m_renderInterval = interval;
+}
+
+void Screen::requestFrame(uint64_t frame)
+{
+	m_requestedFrame = frame;
+}
+
+uint64_t Screen::getFrameCount() const
+{
+	return m_frameCount;
+}
+
+uint64_t Screen::getDrawnLines() const
+{
+	return m_drawnLines;
+}
+
+void Screen::enterMode(uint8_t mode)
+{
+	m_mode = mode;
+	updateStatInterrupt();
+}
+
+const uint8_t* Screen::getFrameBuffer() const
 {
 	return m_frameBuffer;
 }
 
+void Screen::convertFrame(const uint8_t* frame, PixelFormat format, uint8_t* dst)
+{
+	const PixelKernels& kernels = PixelKernels::best();
+	uint8_t grays[16] = {};
+	for (uint8_t shade = 0; shade < 4; shade++)
+	{
+		grays[shade] = fromColorIdtoColor(shade);
+	}
+
+	constexpr int nbPixels = SCREEN_WIDTH * SCREEN_HEIGHT;
+	switch (format)
+	{
+	case PixelFormat::Shade8:
+		std::memcpy(dst, frame, nbPixels);
+		break;
+	case PixelFormat::Gray8:
+		kernels.lookup(frame, grays, dst, nbPixels);
+		break;
+	case PixelFormat::Rgba8888:
+		kernels.toRgba(frame, grays, dst, nbPixels);
+		break;
+	}
+}
+
 void Screen::setSCY(uint8_t scy)
 {
 	m_scy = scy;
@@ -94,11 +205,36 @@ uint8_t Screen::getLY() const
 void Screen::setLYC(uint8_t lyc)
 {
 	m_lyc = lyc;
+	if (m_memory != nullptr)
+	{
+		updateStatInterrupt();
+	}
 }
 
 void Screen::enableLCD(bool enabled)
 {
+	if (enabled == m_lcdEnabled)
+	{
+		return;
+	}
 	m_lcdEnabled = enabled;
+
+	if (m_memory == nullptr)
+	{
+		return;
+	}
+
+	if (enabled)
+	{
+		startLCD(m_memory->getScheduler().now());
+	}
+	else
+	{
+		m_memory->getScheduler().cancel(utils::Event::PPU);
+		m_ly = 0;
+		m_mode = 0;
+		updateStatInterrupt();
+	}
 }
 
 void Screen::enableWindow(bool enabled)
@@ -108,7 +244,7 @@ void Screen::enableWindow(bool enabled)
 
 void Screen::enableObj(bool enabled)
 {
-	m_objectEnable = true;
+	m_objectEnable = enabled;
 }
 
 void Screen::enablePriority(bool enabled)
@@ -119,6 +255,7 @@ void Screen::enablePriority(bool enabled)
 void Screen::setObjSize(uint8_t size)
 {
 	m_ObjectSize = size;
+	m_objectLines.setObjectHeight(size);
 }
 
 void Screen::setWindowTileMapAddr(uint16_t addr)
@@ -146,140 +283,261 @@ void Screen::setBGPalette(uint8_t bgPalette)
 	m_bgPalette = bgPalette;
 }
 
-void Screen::updateStatusRegister()
+uint8_t Screen::getSTAT() const
 {
-	uint8_t status = m_memory->read8(0xFF41);
-	if (!m_lcdEnabled)
+	// Bit 7 always reads 1, mode 0 while the LCD is off.
+	uint8_t status = 0x80 | m_statEnable;
+	if (m_lcdEnabled)
 	{
-		m_scanlineCounter = 0;
-		m_ly = 0;
+		status |= m_mode;
+		if (m_ly == m_lyc)
+		{
+			status = utils::setBit(status, 2);
+		}
+	}
+	return status;
+}
 
-		// Set mode to 1
-		status &= 0xFC;
-		status |= 1;
-		m_memory->write8(0xFF41, status);
+void Screen::setSTAT(uint8_t stat)
+{
+	m_statEnable = stat & 0x78;
+	if (m_memory != nullptr)
+	{
+		updateStatInterrupt();
+	}
+}
 
-		return;
+void Screen::updateStatInterrupt()
+{
+	// The sources share one interrupt line, requested when it goes high.
+	bool line = false;
+	if (m_lcdEnabled)
+	{
+		line = (m_mode == 0 && utils::testBit(m_statEnable, 3))
+			|| (m_mode == 1 && utils::testBit(m_statEnable, 4))
+			|| (m_mode == 2 && utils::testBit(m_statEnable, 5))
+			|| (m_ly == m_lyc && utils::testBit(m_statEnable, 6));
 	}
 
-	uint8_t currentMode = status & 0x03;
-	bool requestInterrupt = false;
+	if (line && !m_statLine)
+	{
+		m_memory->requestInterrupt(1);
+	}
+	m_statLine = line;
+}
 
-	// VBlank
-	if (m_ly >= 144)
+void Screen::renderLine(uint8_t line)
+{
+	if (m_objectEnable)
 	{
-		status = utils::resetBit(status, 0);
-		status = utils::setBit(status, 1);
-		requestInterrupt = utils::testBit(status, 4);
+		selectObjects(line);
+	}
+
+	// Lines equal to what the back buffer already holds are left as is.
+	uint64_t fingerprint = lineFingerprint(line);
+	m_frames.getBackChangedLines()[line] = fingerprint != m_lineFingerprints[line];
+	m_lineFingerprints[line] = fingerprint;
+
+	uint64_t& drawn = m_bufferFingerprints[m_frames.getBackIndex()][line];
+	if (fingerprint == drawn)
+	{
+		return;
+	}
+	drawn = fingerprint;
+	m_drawnLines++;
+
+	uint8_t* ids = m_lineIds + 8;
+	if (m_bgAndWindowPriority)
+	{
+		renderBG(line);
+		renderWindow();
 	}
 	else
 	{
-		if (m_scanlineCounter < 80)
-		{
-			// Mode 2
-			status = utils::setBit(status, 1);
-			status = utils::resetBit(status, 0);
-			requestInterrupt = utils::testBit(status, 5);
-		}
-		else if (m_scanlineCounter < 172)
-		{
-			// Mode 3
-			status = utils::setBit(status, 0);
-			status = utils::setBit(status, 1);
-		}
-		else
-		{
-			// Mode 0
-			status = utils::resetBit(status, 0);
-			status = utils::resetBit(status, 1);
-			requestInterrupt = utils::testBit(status, 3);
-		}
+		std::fill_n(ids, SCREEN_WIDTH, 0);
+	}
+
+	if (m_objectEnable)
+	{
+		renderObjects(line);
 	}
 
-	if (requestInterrupt && (currentMode != (status & 0x03)))
+	uint8_t palettes[3] = { m_bgPalette, m_memory->ioRegister(0xFF48), m_memory->ioRegister(0xFF49) };
+	for (int i = 0; i < 12; i++)
 	{
-		uint8_t if_flag = m_memory->read8(0xFF0F);
-		if_flag = utils::setBit(if_flag, 1);
-		m_memory->write8(0xFF0F, if_flag);
+		m_lineShades[i] = applyPalette(palettes[i / 4], i % 4);
 	}
+	m_kernels.lookup(ids, m_lineShades, m_frameBuffer + line * SCREEN_WIDTH, SCREEN_WIDTH);
+}
+
+uint64_t Screen::lineFingerprint(uint8_t line)
+{
+	const uint8_t* vram = m_memory->getVideoRam();
+	uint8_t obp0 = m_memory->ioRegister(0xFF48);
+	uint8_t obp1 = m_memory->ioRegister(0xFF49);
+
+	// 0 is kept for lines never drawn, see m_bufferFingerprints.
+	uint64_t hash = mix(1, m_bgAndWindowPriority | m_windowVisible << 1 | m_objectEnable << 2 | m_ObjectSize << 3);
+	hash = mix(hash, m_bgPalette | obp0 << 8 | obp1 << 16 | (uint64_t)m_tileDataArea << 24 | (uint64_t)m_bgTileMapAddr << 40);
+
+	// The whole tile map row, and the data of the tiles visible on the line.
+	// Versions only grow, their sum changes whenever one of them does.
+	auto mixTiles = [&](uint16_t tileMapRow, uint8_t firstTile, int count) {
+		const uint8_t* tileMap = vram + (tileMapRow - 0x8000);
+		uint64_t words[4];
+		std::memcpy(words, tileMap, sizeof(words));
+
+		uint64_t versions = 0;
+		for (int i = 0; i < count; i++)
+		{
+			versions += m_tileCache.getVersion(fromTileIdtoIndex(tileMap[(firstTile + i) % 32]));
+		}
+		hash = mix(mix(mix(mix(mix(hash, words[0]), words[1]), words[2]), words[3]), versions);
+	};
 
-	if (m_ly == m_lyc)
+	if (m_bgAndWindowPriority)
 	{
-		status = utils::setBit(status, 2);
-		if (utils::testBit(status, 6))
+		uint8_t y = m_scy + line;
+		hash = mix(hash, m_scx | y << 8);
+		mixTiles(m_bgTileMapAddr + (y / 8) * 32, m_scx / 8, (m_scx % 8 + backgroundWidth() + 7) / 8);
+
+		if (m_windowVisible)
 		{
-			uint8_t if_flag = m_memory->read8(0xFF0F);
-			if_flag = utils::setBit(if_flag, 1);
-			m_memory->write8(0xFF0F, if_flag);
+			hash = mix(hash, m_wx | m_windowLine << 8 | (uint64_t)m_windowTileMapAddr << 16);
+			mixTiles(m_windowTileMapAddr + (m_windowLine / 8) * 32, 0, (SCREEN_WIDTH + 7 - m_wx + 7) / 8);
 		}
 	}
-	else
+
+	if (m_objectEnable)
 	{
-		status = utils::resetBit(status, 2);
+		const uint8_t* oam = m_memory->getOam();
+		for (int n = 0; n < m_nbLineObjects; n++)
+		{
+			const uint8_t* object = oam + m_lineObjects[n] * 4;
+			uint8_t tileId = m_ObjectSize == 16 ? object[2] & 0xFE : object[2];
+			uint64_t versions = m_tileCache.getVersion(tileId) | (uint64_t)m_tileCache.getVersion(tileId + 1) << 32;
+			hash = mix(hash, object[0] | object[1] << 8 | object[2] << 16 | (uint64_t)object[3] << 24);
+			hash = mix(hash, versions);
+		}
 	}
 
-	m_memory->write8(0xFF41, status);
+	return hash != 0 ? hash : 1;
 }
 
 void Screen::renderBG(uint8_t line)
 {
-	uint16_t tileMapY = m_scy / 8 + line / 8;
-	uint16_t startAddr = m_bgTileMapAddr + tileMapY * 32;
+	uint8_t y = m_scy + line;
+	uint16_t tileMapRow = m_bgTileMapAddr + (y / 8) * 32;
 
-	for (uint8_t tileY = 0; tileY < 8; tileY++)
-	{
-		for (uint8_t x = 0; x < SCREEN_WIDTH; x++)
-		{
-			uint8_t tileMapX = (x + m_scx) / 8;
-			uint8_t tilePixel = (x + m_scx) % 8;
+	// Only the tiles left of the window are decoded, 21 of them cover a line
+	// without window whatever the fine scroll.
+	uint8_t fineX = m_scx % 8;
+	drawTileRow(m_lineIds + 8 - fineX, tileMapRow, m_scx / 8, y % 8, (fineX + backgroundWidth() + 7) / 8);
+}
 
-			uint16_t tileIdAddress = startAddr + tileMapX;
-			uint8_t tileId = m_memory->read8(tileIdAddress);
-			uint16_t tileAdress = fromTileIdtoAdress(tileId);
+void Screen::renderWindow()
+{
+	if (!m_windowVisible)
+	{
+		return;
+	}
 
-			uint64_t tileLine = getTileLine(tileAdress, tileY);
+	// The window starts at WX - 7, hidden pixels left of the screen land in
+	// the first 8 bytes of the buffer.
+	uint16_t tileMapRow = m_windowTileMapAddr + (m_windowLine / 8) * 32;
+	int count = (SCREEN_WIDTH + 7 - m_wx + 7) / 8;
+	drawTileRow(m_lineIds + 1 + m_wx, tileMapRow, 0, m_windowLine % 8, count);
+}
 
-			uint8_t colorId = ((uint8_t*)&tileLine)[tilePixel];
-			m_frameBuffer[line * SCREEN_WIDTH * 4 + x * 4] = 255 - fromColorIdtoColor(colorId);
-			m_frameBuffer[line * SCREEN_WIDTH * 4 + x * 4 + 1] = 255 - fromColorIdtoColor(colorId);
-			m_frameBuffer[line * SCREEN_WIDTH * 4 + x * 4 + 2] = 255 - fromColorIdtoColor(colorId);
-			m_frameBuffer[line * SCREEN_WIDTH * 4 + x * 4 + 3] = 255;
-		}
+int Screen::backgroundWidth() const
+{
+	if (!m_windowVisible)
+	{
+		return SCREEN_WIDTH;
 	}
+	return m_wx > 7 ? m_wx - 7 : 0;
 }
-uint64_t Screen::getTileLine(uint16_t tileAddr, uint8_t line)
+
+void Screen::selectObjects(uint8_t line)
 {
-	// We pair the two Bytes of a given line into pairs of bits store in a 8 byte value
-	// This is an trick to easily get the pixels colors.
-	uint64_t a = m_memory->read8(tileAddr + line * 2);
-	uint64_t tmpA = a * 0x0100040010004001 & 0x0001000100010001;
-	uint64_t tmpB = a * 0x0002000800200080 & 0x0100010001000100;
-	a = tmpA | tmpB;
+	m_nbLineObjects = m_objectLines.select(line, m_lineObjects);
+}
 
-	uint64_t b = m_memory->read8(tileAddr + line * 2 + 1);
-	tmpA = b * 0x0100040010004001 & 0x0001000100010001;
-	tmpB = b * 0x0002000800200080 & 0x0100010001000100;
-	b = (tmpA | tmpB) << 1;
+void Screen::renderObjects(uint8_t line)
+{
+	const uint8_t* oam = m_memory->getOam();
+	uint8_t* ids = m_lineIds + 8;
 
-	return a | b;
+	// A pixel belongs to the first object with a non transparent color there,
+	// even if the background then hides it.
+	bool taken[SCREEN_WIDTH] = {};
+	for (int n = 0; n < m_nbLineObjects; n++)
+	{
+		const uint8_t* object = oam + m_lineObjects[n] * 4;
+		int left = object[1] - 8;
+		uint8_t attributes = object[3];
+
+		uint8_t tileY = (uint8_t)(line - (object[0] - 16));
+		if (utils::testBit(attributes, 6))
+		{
+			tileY = m_ObjectSize - 1 - tileY;
+		}
+		// Rows 8-15 of tall objects are in the next tile.
+		uint8_t tileId = m_ObjectSize == 16 ? object[2] & 0xFE : object[2];
+		const uint8_t* colorIds = m_tileCache.getRow(tileId + (tileY >> 3), tileY & 7);
+
+		uint8_t paletteBase = utils::testBit(attributes, 4) ? 8 : 4;
+		bool behindBG = utils::testBit(attributes, 7);
+		bool flipX = utils::testBit(attributes, 5);
+		for (int px = 0; px < 8; px++)
+		{
+			int x = left + px;
+			uint8_t colorId = colorIds[flipX ? 7 - px : px];
+			if (x < 0 || x >= SCREEN_WIDTH || colorId == 0 || taken[x])
+			{
+				continue;
+			}
+
+			taken[x] = true;
+			if (!behindBG || ids[x] == 0)
+			{
+				ids[x] = paletteBase + colorId;
+			}
+		}
+	}
 }
 
-uint16_t Screen::fromTileIdtoAdress(uint8_t tileId)
+void Screen::drawTileRow(uint8_t* dst, uint16_t tileMapRow, uint8_t firstTile, uint8_t tileY, int count)
+{
+	const uint8_t* tileMap = m_memory->getVideoRam() + (tileMapRow - 0x8000);
+	for (int i = 0; i < count; i++, dst += 8)
+	{
+		uint8_t tileId = tileMap[(firstTile + i) % 32];
+		std::memcpy(dst, m_tileCache.getRow(fromTileIdtoIndex(tileId), tileY), 8);
+	}
+}
+
+uint16_t Screen::fromTileIdtoIndex(uint8_t tileId)
 {
-	uint8_t tileMemorySize = 16;
 	switch (m_tileDataArea)
 	{
 	case 0x8800:
-		return m_tileDataArea + (tileId + 128) * tileMemorySize;
+		// Signed ids, 0 is at 0x9000.
+		return 256 + (int8_t)tileId;
 	case 0x8000:
 	default:
-		return m_tileDataArea + tileId * tileMemorySize;
+		return tileId;
 	}
 }
 
-uint8_t Screen::fromColorIdtoColor(uint8_t colorId)
+uint8_t Screen::fromColorIdtoColor(uint8_t shade)
+{
+	return 255 - shade * 85;
+}
+
+uint8_t Screen::applyPalette(uint8_t palette, uint8_t colorId)
 {
-	return  m_bgPalette & (0b0000'0011 << (colorId*2));
+	return (palette >> (colorId * 2)) & 0x03;
 }
 
 }
@@ -0,0 +1,22 @@
+#include "video/tile_cache.h"
+
+namespace video
+{
+TileCache::TileCache()
+	: m_kernels(PixelKernels::best())
+{
+	m_dirty.set();
+}
+
+void TileCache::setVideoRam(const uint8_t* videoRam)
+{
+	m_videoRam = videoRam;
+	m_dirty.set();
+}
+
+void TileCache::decode(uint16_t tile)
+{
+	m_kernels.decodeTile(m_videoRam + tile * 16, m_tiles[tile]);
+	m_dirty.reset(tile);
+}
+}
@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+
+#include "test_system.h"
+
+namespace
+{
+using tests::System;
+
+struct Program
+{
+    std::string name;
+    std::vector<std::pair<uint16_t, std::vector<uint8_t>>> chunks;
+    uint16_t endPC;
+};
+
+std::string writeRom(const Program& program)
+{
+    std::vector<uint8_t> rom(0x8000, 0);
+    for (const auto& [addr, bytes] : program.chunks)
+    {
+        std::copy(bytes.begin(), bytes.end(), rom.begin() + addr);
+    }
+
+    return tests::writeRom(program.name, rom);
+}
+
+std::vector<Program> getTestCases()
+{
+    return
+    {
+        { "loop_and_calls", {
+            { 0x100, {
+                0x21, 0x00, 0xC0, // ld hl, 0xC000
+                0x06, 0x10,       // ld b, 0x10
+                0x78,             // 0x105: ld a, b
+                0xCB, 0x27,       // sla a
+                0x80,             // add a, b
+                0x22,             // ld (hl+), a
+                0xCD, 0x20, 0x01, // call 0x120
+                0x05,             // dec b
+                0x20, 0xF5,       // jr nz, 0x105
+                0x18, 0x00,       // jr 0x112
+                0x18, 0xFE        // 0x112: jr 0x112
+            }},
+            { 0x120, {
+                0xC5,             // push bc
+                0x0C,             // inc c
+                0x79,             // ld a, c
+                0xA8,             // xor b
+                0x57,             // ld d, a
+                0xC1,             // pop bc
+                0x0C,             // inc c
+                0xC9              // ret
+            }}}, 0x112 },
+        { "patched_wram_routine", {
+            { 0x100, {
+                0x21, 0x00, 0xC0, // ld hl, 0xC000
+                0x36, 0x3E,       // ld (hl), 0x3E  ; ld a, n
+                0x23,             // inc hl
+                0x36, 0x01,       // ld (hl), 0x01
+                0x23,             // inc hl
+                0x36, 0xC9,       // ld (hl), 0xC9  ; ret
+                0xCD, 0x00, 0xC0, // call 0xC000
+                0x47,             // ld b, a
+                0x3E, 0x05,       // ld a, 0x05
+                0xEA, 0x01, 0xC0, // ld (0xC001), a
+                0xCD, 0x00, 0xC0, // call 0xC000
+                0x4F,             // ld c, a
+                0x18, 0x00,       // jr 0x11A
+                0x18, 0xFE        // 0x11A: jr 0x11A
+            }}}, 0x11A },
+        { "self_modifying_block", {
+            { 0x100, {
+                0x21, 0x00, 0xC0, // ld hl, 0xC000
+                0x11, 0x40, 0x01, // ld de, 0x140
+                0x0E, 0x08,       // ld c, 8
+                0x1A,             // 0x108: ld a, (de)
+                0x22,             // ld (hl+), a
+                0x13,             // inc de
+                0x0D,             // dec c
+                0x20, 0xFA,       // jr nz, 0x108
+                0xAF,             // xor a
+                0xCD, 0x00, 0xC0, // call 0xC000
+                0x47,             // ld b, a
+                0x18, 0x00,       // jr 0x115
+                0x18, 0xFE        // 0x115: jr 0x115
+            }},
+            { 0x140, {
+                0x21, 0x06, 0xC0, // ld hl, 0xC006
+                0x36, 0x3C,       // ld (hl), 0x3C  ; inc a
+                0x00,             // nop
+                0x00,             // nop, patched above
+                0xC9              // ret
+            }}}, 0x115 }
+    };
+}
+
+class BlockCacheTests : public testing::TestWithParam<Program>
+{};
+INSTANTIATE_TEST_CASE_P(BlockCacheTests, BlockCacheTests, testing::ValuesIn(getTestCases()));
+
+TEST_P(BlockCacheTests, sameStateAsInterpreter)
+{
+    const Program& program = GetParam();
+    std::string romPath = writeRom(program);
+
+    auto interpreted = std::make_unique<System>(romPath);
+    auto cached = std::make_unique<System>(romPath);
+
+    for (int i = 0; i < 10000 && interpreted->registers.getPC() != program.endPC; i++)
+    {
+        interpreted->processor.runNextInstruction(false);
+    }
+    for (int i = 0; i < 10000 && cached->registers.getPC() != program.endPC; i++)
+    {
+        cached->processor.runNextBlock();
+    }
+
+    ASSERT_EQ(interpreted->registers.getPC(), program.endPC);
+    ASSERT_EQ(cached->registers.getPC(), program.endPC);
+
+    EXPECT_EQ(interpreted->processor.getCycles(), cached->processor.getCycles());
+    EXPECT_EQ(interpreted->registers.read16<cpu::Registers::AF>(), cached->registers.read16<cpu::Registers::AF>());
+    EXPECT_EQ(interpreted->registers.read16<cpu::Registers::BC>(), cached->registers.read16<cpu::Registers::BC>());
+    EXPECT_EQ(interpreted->registers.read16<cpu::Registers::DE>(), cached->registers.read16<cpu::Registers::DE>());
+    EXPECT_EQ(interpreted->registers.read16<cpu::Registers::HL>(), cached->registers.read16<cpu::Registers::HL>());
+    EXPECT_EQ(interpreted->registers.getSP(), cached->registers.getSP());
+
+    for (uint16_t addr = 0xC000; addr < 0xC100; addr++)
+    {
+        EXPECT_EQ(interpreted->memory.read8(addr), cached->memory.read8(addr)) << "at 0x" << std::hex << addr;
+    }
+}
+
+TEST(BlockCacheTests, patchedCodeIsRedecoded)
+{
+    std::string romPath = writeRom(getTestCases()[1]);
+    auto system = std::make_unique<System>(romPath);
+
+    while (system->registers.getPC() != 0x11A)
+    {
+        system->processor.runNextBlock();
+    }
+
+    EXPECT_EQ(system->registers.read8<cpu::Registers::B>(), 0x01);
+    EXPECT_EQ(system->registers.read8<cpu::Registers::C>(), 0x05);
+}
+
+TEST(BlockCacheTests, blockOverwritingItself)
+{
+    std::string romPath = writeRom(getTestCases()[2]);
+    auto system = std::make_unique<System>(romPath);
+
+    while (system->registers.getPC() != 0x115)
+    {
+        system->processor.runNextBlock();
+    }
+
+    EXPECT_EQ(system->registers.read8<cpu::Registers::B>(), 0x01);
+}
+
+TEST(BlockCacheTests, bankSwitchInsideBlock)
+{
+    // MBC1, the same code in banks 1 and 2 but for the value loaded in B.
+    std::vector<uint8_t> rom(4 * 0x4000, 0);
+    rom[0x147] = 0x01;
+    rom[0x148] = 0x01;
+    const std::vector<uint8_t> start = { 0xC3, 0x00, 0x40 }; // jp 0x4000
+    std::copy(start.begin(), start.end(), rom.begin() + 0x100);
+    for (int bank : { 1, 2 })
+    {
+        const std::vector<uint8_t> code = {
+            0x3E, 0x02,         // 0x4000: ld a, 2
+            0xEA, 0x00, 0x20,   // 0x4002: ld (0x2000), a  ; bank 2
+            0x06, (uint8_t)(0x11 * bank), // 0x4005: ld b, n
+            0x18, 0xFE          // 0x4007: jr 0x4007
+        };
+        std::copy(code.begin(), code.end(), rom.begin() + bank * 0x4000);
+    }
+    std::string romPath = tests::writeRom("block_bank_switch", rom);
+
+    auto interpreted = std::make_unique<System>(romPath);
+    auto cached = std::make_unique<System>(romPath);
+    for (int i = 0; i < 100 && interpreted->registers.getPC() != 0x4007; i++)
+    {
+        interpreted->processor.runNextInstruction(false);
+    }
+    for (int i = 0; i < 100 && cached->registers.getPC() != 0x4007; i++)
+    {
+        cached->processor.runNextBlock();
+    }
+
+    EXPECT_EQ(interpreted->registers.read8<cpu::Registers::B>(), 0x22);
+    EXPECT_EQ(cached->registers.read8<cpu::Registers::B>(), 0x22);
+}
+}
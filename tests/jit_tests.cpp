@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+
+#include "test_system.h"
+
+#include <array>
+#include <random>
+
+namespace
+{
+constexpr uint16_t loopPC = 0x102;
+
+using tests::System;
+
+// Random loop body mixing natively translated instructions with ones going
+// through their handler. B is the loop counter and HL points to WRAM.
+std::vector<uint8_t> randomBody(std::mt19937& rng)
+{
+    constexpr uint8_t dests[] = { 7, 1, 2, 3 };          // A, C, D, E
+    constexpr uint8_t srcs[] = { 0, 1, 2, 3, 4, 5, 7 };  // B, C, D, E, H, L, A
+    constexpr uint8_t misc[] = { 0x00, 0x07, 0x0F, 0x17, 0x1F, 0x27, 0x2F, 0x37, 0x3F };
+    constexpr uint8_t conditions[] = { 0x20, 0x28, 0x30, 0x38 };
+
+    auto pick = [&](const auto& values) { return values[rng() % std::size(values)]; };
+    auto n = [&]() { return (uint8_t)rng(); };
+
+    std::vector<uint8_t> body;
+    int count = 8 + rng() % 20;
+    for (int i = 0; i < count; i++)
+    {
+        uint8_t d = pick(dests);
+        uint8_t s = pick(srcs);
+        switch (rng() % 12)
+        {
+        case 0: body.insert(body.end(), { (uint8_t)(0x40 | d << 3 | s) }); break;     // ld d, s
+        case 1: body.insert(body.end(), { (uint8_t)(0x06 | d << 3), n() }); break;    // ld d, n
+        case 2: body.insert(body.end(), { (uint8_t)(0x80 | (rng() % 8) << 3 | s) }); break; // alu A, s
+        case 3: body.insert(body.end(), { (uint8_t)(0xC6 | (rng() % 8) << 3), n() }); break; // alu A, n
+        case 4: body.insert(body.end(), { (uint8_t)(0x04 | d << 3) }); break;         // inc d
+        case 5: body.insert(body.end(), { (uint8_t)(0x05 | d << 3) }); break;         // dec d
+        case 6: body.insert(body.end(), { pick(std::array<uint8_t, 5>{ 0x13, 0x1B, 0x23, 0x33, 0x3B }) }); break; // inc/dec rr
+        case 7: body.insert(body.end(), { pick(std::array<uint8_t, 3>{ 0x77, 0x7E, 0x22 }) }); break; // (hl) accesses
+        case 8: body.insert(body.end(), { 0x36, n() }); break;                       // ld (hl), n
+        case 9: body.insert(body.end(), { 0xD5, 0xD1 }); break;                      // push de, pop de
+        case 10: body.insert(body.end(), { 0xCB, (uint8_t)((rng() % 0x40) | d) }); break; // rotates, shifts
+        case 11: body.insert(body.end(), { pick(conditions), 0x01, pick(misc) }); break; // jr cc, +1
+        }
+    }
+
+    return body;
+}
+
+std::string writeRom(const std::string& name, const std::vector<uint8_t>& body, bool absoluteJump, uint16_t& endPC)
+{
+    std::vector<uint8_t> program = {
+        0x06, 0x28,         // ld b, 40
+        0x21, 0x00, 0xC0    // loop: ld hl, 0xC000
+    };
+    program.insert(program.end(), body.begin(), body.end());
+    program.push_back(0x05); // dec b
+
+    if (absoluteJump)
+    {
+        program.insert(program.end(), { 0xC2, loopPC & 0xFF, loopPC >> 8 }); // jp nz, loop
+    }
+    else
+    {
+        int offset = loopPC - (0x100 + (int)program.size() + 2);
+        program.insert(program.end(), { 0x20, (uint8_t)offset });           // jr nz, loop
+    }
+    program.insert(program.end(), { 0x18, 0x00 }); // jr end
+    endPC = 0x100 + program.size();
+    program.insert(program.end(), { 0x18, 0xFE }); // end: jr end
+
+    return tests::writeRom(name, tests::romWithCode(program));
+}
+
+class JitTests : public testing::TestWithParam<unsigned>
+{};
+INSTANTIATE_TEST_CASE_P(JitTests, JitTests, testing::Range(0u, 64u));
+
+TEST_P(JitTests, sameStateAsInterpreter)
+{
+    std::mt19937 rng(GetParam());
+    std::vector<uint8_t> body = randomBody(rng);
+
+    uint16_t endPC = 0;
+    std::string romPath = writeRom("jit_" + std::to_string(GetParam()), body, GetParam() % 2 == 1, endPC);
+
+    auto interpreted = std::make_unique<System>(romPath);
+    auto compiled = std::make_unique<System>(romPath);
+
+    for (int i = 0; i < 100000 && interpreted->registers.getPC() != endPC; i++)
+    {
+        interpreted->processor.runNextInstruction(false);
+    }
+    for (int i = 0; i < 100000 && compiled->registers.getPC() != endPC; i++)
+    {
+        compiled->processor.runNextBlock();
+    }
+
+    ASSERT_EQ(interpreted->registers.getPC(), endPC);
+    ASSERT_EQ(compiled->registers.getPC(), endPC);
+    EXPECT_GT(compiled->processor.getCompiledBlocks(), 0u);
+
+    EXPECT_EQ(interpreted->processor.getCycles(), compiled->processor.getCycles());
+    EXPECT_EQ(interpreted->registers.read16<cpu::Registers::AF>(), compiled->registers.read16<cpu::Registers::AF>());
+    EXPECT_EQ(interpreted->registers.read16<cpu::Registers::BC>(), compiled->registers.read16<cpu::Registers::BC>());
+    EXPECT_EQ(interpreted->registers.read16<cpu::Registers::DE>(), compiled->registers.read16<cpu::Registers::DE>());
+    EXPECT_EQ(interpreted->registers.read16<cpu::Registers::HL>(), compiled->registers.read16<cpu::Registers::HL>());
+    EXPECT_EQ(interpreted->registers.getSP(), compiled->registers.getSP());
+
+    for (uint16_t addr = 0xC000; addr < 0xC100; addr++)
+    {
+        EXPECT_EQ(interpreted->memory.read8(addr), compiled->memory.read8(addr)) << "at 0x" << std::hex << addr;
+    }
+    for (uint16_t addr = 0xFF80; addr < 0xFFFF; addr++)
+    {
+        EXPECT_EQ(interpreted->memory.read8(addr), compiled->memory.read8(addr)) << "at 0x" << std::hex << addr;
+    }
+    EXPECT_EQ(interpreted->memory.read8(0xFF04), compiled->memory.read8(0xFF04));
+}
+
+TEST(JitTests, ioReadsSeeCurrentClocks)
+{
+    // Reads LY through (hl) after 60 natively run cycles, then stores it at
+    // 0xC000 + B.
+    std::vector<uint8_t> body = { 0x21, 0x44, 0xFF }; // ld hl, 0xFF44
+    body.insert(body.end(), 60, 0x0C);                // inc c
+    body.insert(body.end(), {
+        0x7E,                                         // ld a, (hl)
+        0x26, 0xC0,                                   // ld h, 0xC0
+        0x68,                                         // ld l, b
+        0x77                                          // ld (hl), a
+    });
+
+    uint16_t endPC = 0;
+    std::string romPath = writeRom("jit_io", body, false, endPC);
+
+    auto decoded = std::make_unique<System>(romPath);
+    auto compiled = std::make_unique<System>(romPath);
+    decoded->processor.setJitEnabled(false);
+    while (decoded->registers.getPC() != endPC)
+    {
+        decoded->processor.runNextBlock();
+    }
+    while (compiled->registers.getPC() != endPC)
+    {
+        compiled->processor.runNextBlock();
+    }
+
+    EXPECT_GT(compiled->processor.getCompiledBlocks(), 0u);
+    EXPECT_EQ(decoded->processor.getCycles(), compiled->processor.getCycles());
+    for (uint16_t addr = 0xC000; addr <= 0xC028; addr++)
+    {
+        EXPECT_EQ(decoded->memory.read8(addr), compiled->memory.read8(addr)) << "at 0x" << std::hex << addr;
+    }
+}
+
+TEST(JitTests, interruptsServicedAtTheSameInstruction)
+{
+    // The timer overflows every 64 cycles while a 63 cycle loop runs. The
+    // handler stores C at 0xC000 + n and stops after 64 interrupts.
+    std::vector<uint8_t> code = {
+        0x21, 0x00, 0xC0,   // ld hl, 0xC000
+        0x3E, 0xF0,         // ld a, 0xF0
+        0xE0, 0x06,         // ldh (TMA), a
+        0xE0, 0x05,         // ldh (TIMA), a
+        0x3E, 0x04,         // ld a, 0x04
+        0xE0, 0xFF,         // ldh (IE), a
+        0x3E, 0x05,         // ld a, 0x05
+        0xE0, 0x07,         // ldh (TAC), a  ; 16 T-cycles per tick
+        0xFB                // ei
+    };
+    code.insert(code.end(), 60, 0x0C);                // loop: inc c
+    code.insert(code.end(), { 0x18, (uint8_t)-62 });  // jr loop
+
+    std::vector<uint8_t> rom = tests::romWithCode(code);
+    const std::vector<uint8_t> handler = {
+        0x79,               // 0x200: ld a, c
+        0x22,               // ld (hl+), a
+        0x7D,               // ld a, l
+        0xFE, 0x40,         // cp 0x40
+        0x28, 0x01,         // jr z, 0x208
+        0xD9,               // reti
+        0x18, 0xFE          // 0x208: jr 0x208
+    };
+    constexpr uint16_t endPC = 0x208;
+    rom[0x50] = 0xC3;       // jp 0x200
+    rom[0x51] = 0x00;
+    rom[0x52] = 0x02;
+    std::copy(handler.begin(), handler.end(), rom.begin() + 0x200);
+    std::string romPath = tests::writeRom("jit_interrupts", rom);
+
+    auto interpreted = std::make_unique<System>(romPath);
+    auto compiled = std::make_unique<System>(romPath);
+    for (int i = 0; i < 100000 && interpreted->registers.getPC() != endPC; i++)
+    {
+        interpreted->processor.runNextInstruction(false);
+    }
+    for (int i = 0; i < 100000 && compiled->registers.getPC() != endPC; i++)
+    {
+        compiled->processor.runNextBlock();
+    }
+
+    ASSERT_EQ(interpreted->registers.getPC(), endPC);
+    ASSERT_EQ(compiled->registers.getPC(), endPC);
+    EXPECT_GT(compiled->processor.getCompiledBlocks(), 0u);
+    EXPECT_EQ(interpreted->processor.getCycles(), compiled->processor.getCycles());
+    EXPECT_EQ(interpreted->registers.read16<cpu::Registers::BC>(), compiled->registers.read16<cpu::Registers::BC>());
+    for (uint16_t addr = 0xC000; addr < 0xC040; addr++)
+    {
+        EXPECT_EQ(interpreted->memory.read8(addr), compiled->memory.read8(addr)) << "at 0x" << std::hex << addr;
+    }
+}
+
+TEST(JitTests, disabledRunsDecodedBlocks)
+{
+    std::mt19937 rng(0);
+    uint16_t endPC = 0;
+    std::string romPath = writeRom("jit_disabled", randomBody(rng), false, endPC);
+
+    auto system = std::make_unique<System>(romPath);
+    system->processor.setJitEnabled(false);
+    while (system->registers.getPC() != endPC)
+    {
+        system->processor.runNextBlock();
+    }
+
+    EXPECT_EQ(system->processor.getCompiledBlocks(), 0u);
+}
+}
@@ -0,0 +1,397 @@
+#include <gtest/gtest.h>
+
+#include "memory/mbc.h"
+#include "test_system.h"
+
+#include <bit>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+using tests::System;
+
+// Each bank filled with its own number.
+std::string writeBankedRom(const std::string& name, int nbBanks, uint8_t type = 0x00, uint8_t ramSize = 0x00)
+{
+    std::vector<uint8_t> rom(nbBanks * 0x4000);
+    for (int bank = 0; bank < nbBanks; bank++)
+    {
+        std::fill(rom.begin() + bank * 0x4000, rom.begin() + (bank + 1) * 0x4000, (uint8_t)bank);
+    }
+    rom[0x147] = type;
+    rom[0x148] = (uint8_t)(std::countr_zero((unsigned)nbBanks) - 1);
+    rom[0x149] = ramSize;
+
+    std::string path = tests::writeRom(name, rom);
+    std::filesystem::remove(std::filesystem::path(path).replace_extension(".sav"));
+
+    return path;
+}
+
+TEST(MemoryTests, romBanks)
+{
+    auto system = std::make_unique<System>(writeBankedRom("memory_banks", 4));
+    Memory& memory = system->memory;
+
+    EXPECT_EQ(memory.read8(0x0150), 0);
+    EXPECT_EQ(memory.read8(0x4000), 1);
+    EXPECT_EQ(memory.getRomBank(), 1);
+
+    memory.setRomBank(3);
+    EXPECT_EQ(memory.read8(0x4000), 3);
+    EXPECT_EQ(memory.read8(0x7FFF), 3);
+    EXPECT_EQ(memory.read8(0x3FFF), 0);
+
+    // ROM is read only.
+    memory.write8(0x4000, 0xAA);
+    EXPECT_EQ(memory.read8(0x4000), 3);
+}
+
+TEST(MemoryTests, ramAndEcho)
+{
+    auto system = std::make_unique<System>(writeBankedRom("memory_ram", 2));
+    Memory& memory = system->memory;
+
+    memory.write8(0x8010, 0x12);
+    EXPECT_EQ(memory.read8(0x8010), 0x12);
+
+    memory.write16(0xC0FF, 0xBEEF);
+    EXPECT_EQ(memory.read16(0xC0FF), 0xBEEF);
+    EXPECT_EQ(memory.read16(0xE0FF), 0xBEEF);
+
+    memory.write8(0xFDFF, 0x34);
+    EXPECT_EQ(memory.read8(0xDDFF), 0x34);
+
+    memory.write8(0xFF80, 0x56);
+    EXPECT_EQ(memory.read8(0xFF80), 0x56);
+}
+
+TEST(MemoryTests, externalRam)
+{
+    auto system = std::make_unique<System>(writeBankedRom("memory_external_ram", 2));
+    Memory& memory = system->memory;
+
+    uint8_t bank[0x2000] = {};
+    memory.setRamBank(bank);
+    memory.write8(0xA123, 0x78);
+    EXPECT_EQ(bank[0x123], 0x78);
+
+    memory.setRamBank(nullptr);
+    EXPECT_EQ(memory.read8(0xA123), 0xFF);
+    memory.write8(0xA123, 0x00);
+    EXPECT_EQ(bank[0x123], 0x78);
+}
+
+TEST(MemoryTests, oamDma)
+{
+    auto system = std::make_unique<System>(writeBankedRom("memory_dma", 2));
+    Memory& memory = system->memory;
+    utils::Scheduler& scheduler = memory.getScheduler();
+
+    for (uint16_t i = 0; i < 0xA0; i++)
+    {
+        memory.write8(0xC100 + i, (uint8_t)i);
+    }
+    memory.write8(0xFF46, 0xC1);
+    EXPECT_TRUE(memory.isDmaActive());
+
+    // Only HRAM is reachable until the transfer ends.
+    EXPECT_EQ(memory.read8(0xC100), 0xFF);
+    EXPECT_EQ(memory.read8(0x4000), 0xFF);
+    memory.write8(0xC100, 0xAA);
+    memory.write8(0xFF80, 0x56);
+    EXPECT_EQ(memory.read8(0xFF80), 0x56);
+
+    scheduler.advance(160 * 4);
+    EXPECT_FALSE(memory.isDmaActive());
+    EXPECT_EQ(memory.read8(0xC100), 0x00);
+    EXPECT_EQ(memory.read8(0x4000), 1);
+    for (uint16_t i = 0; i < 0xA0; i++)
+    {
+        EXPECT_EQ(memory.read8(0xFE00 + i), i);
+    }
+
+    // Sources past work RAM read its echo.
+    memory.write8(0xFF46, 0xE1);
+    scheduler.advance(160 * 4);
+    EXPECT_EQ(memory.read8(0xFE9F), 0x9F);
+}
+
+TEST(MemoryTests, oamDmaRestarted)
+{
+    auto system = std::make_unique<System>(writeBankedRom("memory_dma_restart", 2));
+    Memory& memory = system->memory;
+    utils::Scheduler& scheduler = memory.getScheduler();
+
+    for (uint16_t i = 0; i < 0xA0; i++)
+    {
+        memory.write8(0xC100 + i, (uint8_t)i);
+        memory.write8(0xC200 + i, (uint8_t)(0xA0 - i));
+    }
+    memory.write8(0xFF46, 0xC1);
+    scheduler.advance(80 * 4);
+    EXPECT_TRUE(memory.isDmaActive());
+
+    // Written from HRAM while the bus is still blocked.
+    memory.write8(0xFF46, 0xC2);
+    for (uint16_t i = 0; i < 0xA0; i++)
+    {
+        EXPECT_EQ(memory.read8(0xFE00 + i), 0xFF);
+    }
+
+    // The second transfer lasts its full 160 M-cycles.
+    scheduler.advance(159 * 4);
+    EXPECT_TRUE(memory.isDmaActive());
+    EXPECT_EQ(memory.read8(0xC200), 0xFF);
+    scheduler.advance(4);
+    EXPECT_FALSE(memory.isDmaActive());
+    EXPECT_EQ(memory.read8(0xC200), 0xA0);
+    for (uint16_t i = 0; i < 0xA0; i++)
+    {
+        EXPECT_EQ(memory.read8(0xFE00 + i), 0xA0 - i);
+    }
+}
+
+TEST(MemoryTests, mbc1)
+{
+    auto system = std::make_unique<System>(writeBankedRom("memory_mbc1", 64, 0x03, 0x03));
+    Memory& memory = system->memory;
+
+    memory.write8(0x2000, 0x05);
+    EXPECT_EQ(memory.read8(0x4000), 5);
+    EXPECT_EQ(memory.read8(0x0200), 0);
+
+    // Bank 0 selects bank 1.
+    memory.write8(0x2000, 0x00);
+    EXPECT_EQ(memory.read8(0x4000), 1);
+
+    // Upper bits, also applied to 0x0000-0x3FFF in advanced mode.
+    memory.write8(0x2000, 0x02);
+    memory.write8(0x4000, 0x01);
+    EXPECT_EQ(memory.read8(0x4000), 0x22);
+    EXPECT_EQ(memory.read8(0x0200), 0);
+    memory.write8(0x6000, 0x01);
+    EXPECT_EQ(memory.read8(0x0200), 0x20);
+    EXPECT_EQ(memory.getLowRomBank(), 0x20);
+
+    // RAM disabled, then banked.
+    EXPECT_EQ(memory.read8(0xA000), 0xFF);
+    memory.write8(0x0000, 0x0A);
+    memory.write8(0xA000, 0x11);
+    memory.write8(0x4000, 0x02);
+    memory.write8(0xA000, 0x22);
+    EXPECT_EQ(memory.read8(0xA000), 0x22);
+    memory.write8(0x4000, 0x01);
+    EXPECT_EQ(memory.read8(0xA000), 0x11);
+}
+
+TEST(MemoryTests, mbc2)
+{
+    auto system = std::make_unique<System>(writeBankedRom("memory_mbc2", 16, 0x06));
+    Memory& memory = system->memory;
+
+    memory.write8(0x2100, 0x0F);
+    EXPECT_EQ(memory.read8(0x4000), 15);
+    // Address bit 8 clear: RAM enable, not a bank switch.
+    memory.write8(0x2000, 0x0A);
+    EXPECT_EQ(memory.read8(0x4000), 15);
+
+    memory.write8(0xA001, 0x35);
+    EXPECT_EQ(memory.read8(0xA001), 0xF5);
+    EXPECT_EQ(memory.read8(0xA201), 0xF5);
+}
+
+TEST(MemoryTests, mbc3)
+{
+    auto system = std::make_unique<System>(writeBankedRom("memory_mbc3", 128, 0x13, 0x03));
+    Memory& memory = system->memory;
+
+    memory.write8(0x2000, 0x7F);
+    EXPECT_EQ(memory.read8(0x7FFF), 127);
+
+    memory.write8(0x0000, 0x0A);
+    memory.write8(0x4000, 0x03);
+    memory.write8(0xBFFF, 0x42);
+    EXPECT_EQ(memory.read8(0xBFFF), 0x42);
+
+    // RTC seconds, read back once latched.
+    memory.write8(0x4000, 0x08);
+    memory.write8(0xA000, 30);
+    memory.write8(0x6000, 0x00);
+    memory.write8(0x6000, 0x01);
+    EXPECT_EQ(memory.read8(0xA000), 30);
+
+    memory.write8(0x4000, 0x03);
+    EXPECT_EQ(memory.read8(0xBFFF), 0x42);
+}
+
+TEST(MemoryTests, mbc5)
+{
+    auto system = std::make_unique<System>(writeBankedRom("memory_mbc5", 512, 0x1B, 0x03));
+    Memory& memory = system->memory;
+
+    memory.write8(0x2000, 0x34);
+    memory.write8(0x3000, 0x01);
+    EXPECT_EQ(memory.getRomBank(), 0x134);
+    EXPECT_EQ(memory.read8(0x4000), 0x34);
+
+    // Bank 0 can be mapped.
+    memory.write8(0x3000, 0x00);
+    memory.write8(0x2000, 0x00);
+    EXPECT_EQ(memory.getRomBank(), 0);
+}
+
+TEST(MemoryTests, sharedRomImage)
+{
+    std::string romPath = writeBankedRom("memory_shared", 8);
+    auto first = std::make_unique<System>(romPath);
+    auto second = std::make_unique<System>(romPath);
+
+    const auto& image = first->cartridge.getImage();
+    EXPECT_EQ(image, second->cartridge.getImage());
+    EXPECT_TRUE(image->isMapped());
+    EXPECT_EQ(image->nbBanks(), 8u);
+    EXPECT_EQ(RomImage::open(romPath.c_str()), image);
+
+    second->memory.setRomBank(7);
+    EXPECT_EQ(second->memory.read8(0x4000), 7);
+    EXPECT_EQ(first->memory.read8(0x4000), 1);
+}
+
+TEST(MemoryTests, truncatedRomIsPadded)
+{
+    std::string path = tests::writeRom("memory_truncated", std::vector<uint8_t>(0x5000, 0x42));
+
+    auto image = RomImage::open(path.c_str());
+    ASSERT_NE(image, nullptr);
+    EXPECT_FALSE(image->isMapped());
+    EXPECT_EQ(image->size(), 0x8000u);
+    EXPECT_EQ(image->data()[0x4FFF], 0x42);
+    EXPECT_EQ(image->data()[0x5000], 0x00);
+
+    EXPECT_EQ(RomImage::open("does_not_exist.gb"), nullptr);
+}
+
+TEST(MemoryTests, batteryRamIsSaved)
+{
+    std::string romPath = writeBankedRom("memory_battery", 4, 0x1B, 0x03);
+    auto savePath = std::filesystem::path(romPath).replace_extension(".sav");
+
+    {
+        auto system = std::make_unique<System>(romPath);
+        Memory& memory = system->memory;
+        memory.write8(0x0000, 0x0A);
+        memory.write8(0x4000, 0x02);
+        memory.write8(0xA010, 0x5A);
+        EXPECT_EQ(memory.read8(0xA010), 0x5A);
+
+        // Page mapped read only again after the periodic flush.
+        memory.getScheduler().advance(BankedRom::flushPeriod);
+        memory.write8(0xA011, 0xA5);
+        EXPECT_EQ(memory.read8(0xA011), 0xA5);
+    }
+
+    // Raw dump of the 4 banks.
+    ASSERT_EQ(std::filesystem::file_size(savePath), 4u * 0x2000);
+    std::ifstream file(savePath, std::ios::binary);
+    std::vector<char> save(4 * 0x2000);
+    file.read(save.data(), save.size());
+    EXPECT_EQ((uint8_t)save[2 * 0x2000 + 0x10], 0x5A);
+    EXPECT_EQ((uint8_t)save[2 * 0x2000 + 0x11], 0xA5);
+
+    auto system = std::make_unique<System>(romPath);
+    Memory& memory = system->memory;
+    memory.write8(0x0000, 0x0A);
+    memory.write8(0x4000, 0x02);
+    EXPECT_EQ(memory.read8(0xA010), 0x5A);
+}
+
+TEST(MemoryTests, batteryRamHasOneOwner)
+{
+    std::string romPath = writeBankedRom("memory_battery_owner", 4, 0x1B, 0x03);
+    auto savePath = std::filesystem::path(romPath).replace_extension(".sav");
+
+    {
+        auto first = std::make_unique<System>(romPath);
+        first->memory.write8(0x0000, 0x0A);
+        first->memory.write8(0xA000, 0x11);
+
+        // The second instance runs on a copy of the file.
+        auto second = std::make_unique<System>(romPath);
+        second->memory.write8(0x0000, 0x0A);
+        EXPECT_EQ(second->memory.read8(0xA000), 0x11);
+        second->memory.write8(0xA000, 0x22);
+        second->memory.write8(0xA001, 0x22);
+
+        EXPECT_EQ(first->memory.read8(0xA000), 0x11);
+        EXPECT_EQ(first->memory.read8(0xA001), 0x00);
+    }
+
+    std::ifstream file(savePath, std::ios::binary);
+    std::vector<char> save(2);
+    file.read(save.data(), save.size());
+    EXPECT_EQ((uint8_t)save[0], 0x11);
+    EXPECT_EQ((uint8_t)save[1], 0x00);
+}
+
+TEST(MemoryTests, mbc3Rtc)
+{
+    constexpr uint64_t secondCycles = 4'194'304;
+    std::string romPath = writeBankedRom("memory_rtc", 4, 0x10, 0x03);
+    auto readRtc = [](Memory& memory, uint8_t reg)
+    {
+        memory.write8(0x4000, reg);
+        return memory.read8(0xA000);
+    };
+
+    {
+        auto system = std::make_unique<System>(romPath);
+        Memory& memory = system->memory;
+        memory.write8(0x0000, 0x0A);
+
+        // 23:59:30, day 255.
+        memory.write8(0x4000, 0x08);
+        memory.write8(0xA000, 30);
+        memory.write8(0x4000, 0x09);
+        memory.write8(0xA000, 59);
+        memory.write8(0x4000, 0x0A);
+        memory.write8(0xA000, 23);
+        memory.write8(0x4000, 0x0B);
+        memory.write8(0xA000, 255);
+
+        // Only moves when latched.
+        memory.getScheduler().advance(45 * secondCycles);
+        EXPECT_EQ(readRtc(memory, 0x08), 0);
+        memory.write8(0x6000, 0x00);
+        memory.write8(0x6000, 0x01);
+        EXPECT_EQ(readRtc(memory, 0x08), 15);
+        EXPECT_EQ(readRtc(memory, 0x09), 0);
+        EXPECT_EQ(readRtc(memory, 0x0A), 0);
+        EXPECT_EQ(readRtc(memory, 0x0B), 0);
+        EXPECT_EQ(readRtc(memory, 0x0C), 0x01);
+
+        // Halted
+        memory.write8(0x4000, 0x0C);
+        memory.write8(0xA000, 0x41);
+        memory.getScheduler().advance(100 * secondCycles);
+        memory.write8(0x6000, 0x00);
+        memory.write8(0x6000, 0x01);
+        EXPECT_EQ(readRtc(memory, 0x08), 15);
+        EXPECT_EQ(readRtc(memory, 0x0C), 0x41);
+    }
+
+    // Saved after the RAM, halted so no time is added on load.
+    auto savePath = std::filesystem::path(romPath).replace_extension(".sav");
+    EXPECT_EQ(std::filesystem::file_size(savePath), 4u * 0x2000 + 48);
+
+    auto system = std::make_unique<System>(romPath);
+    Memory& memory = system->memory;
+    memory.write8(0x0000, 0x0A);
+    memory.write8(0x6000, 0x00);
+    memory.write8(0x6000, 0x01);
+    EXPECT_EQ(readRtc(memory, 0x08), 15);
+    EXPECT_EQ(readRtc(memory, 0x0B), 0);
+    EXPECT_EQ(readRtc(memory, 0x0C), 0x41);
+}
+}
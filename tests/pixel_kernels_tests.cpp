@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include "video/pixel_kernels.h"
+
+#include <random>
+
+namespace
+{
+const video::PixelKernels& scalar()
+{
+    return *video::PixelKernels::available().front();
+}
+
+TEST(PixelKernelsTests, bestIsAvailable)
+{
+    auto kernels = video::PixelKernels::available();
+    EXPECT_STREQ(kernels.front()->name, "scalar");
+    EXPECT_EQ(&video::PixelKernels::best(), kernels.back());
+}
+
+TEST(PixelKernelsTests, decodeTile)
+{
+    // Row 0 of the tile: pixel 0 color 1, pixel 1 color 2, pixel 7 color 3.
+    uint8_t data[16] = { 0x81, 0x41 };
+    uint8_t colorIds[64];
+    scalar().decodeTile(data, colorIds);
+    EXPECT_EQ(colorIds[0], 1);
+    EXPECT_EQ(colorIds[1], 2);
+    EXPECT_EQ(colorIds[2], 0);
+    EXPECT_EQ(colorIds[7], 3);
+    EXPECT_EQ(colorIds[8], 0);
+
+    std::mt19937 rng(0);
+    for (const video::PixelKernels* kernels : video::PixelKernels::available())
+    {
+        for (int i = 0; i < 100; i++)
+        {
+            for (uint8_t& byte : data)
+            {
+                byte = (uint8_t)rng();
+            }
+
+            uint8_t expected[64];
+            scalar().decodeTile(data, expected);
+            kernels->decodeTile(data, colorIds);
+            ASSERT_EQ(0, memcmp(expected, colorIds, sizeof(colorIds))) << kernels->name;
+        }
+    }
+}
+
+TEST(PixelKernelsTests, lookup)
+{
+    uint8_t lut[16];
+    for (int i = 0; i < 16; i++)
+    {
+        lut[i] = (uint8_t)(i * 17 + 3);
+    }
+
+    std::mt19937 rng(1);
+    uint8_t indices[160];
+    for (uint8_t& index : indices)
+    {
+        index = rng() % 16;
+    }
+
+    for (const video::PixelKernels* kernels : video::PixelKernels::available())
+    {
+        uint8_t out[160] = {};
+        kernels->lookup(indices, lut, out, 160);
+        for (int x = 0; x < 160; x++)
+        {
+            ASSERT_EQ(out[x], lut[indices[x]]) << kernels->name << " at " << x;
+        }
+    }
+}
+
+TEST(PixelKernelsTests, toRgba)
+{
+    uint8_t lut[16];
+    for (int i = 0; i < 16; i++)
+    {
+        lut[i] = (uint8_t)(255 - i * 13);
+    }
+
+    std::mt19937 rng(0);
+    uint8_t indices[160];
+    for (uint8_t& index : indices)
+    {
+        index = rng() % 16;
+    }
+
+    uint8_t expected[160 * 4];
+    scalar().toRgba(indices, lut, expected, 160);
+    EXPECT_EQ(expected[4 * 7], lut[indices[7]]);
+    EXPECT_EQ(expected[4 * 7 + 2], lut[indices[7]]);
+    EXPECT_EQ(expected[4 * 7 + 3], 255);
+
+    for (const video::PixelKernels* kernels : video::PixelKernels::available())
+    {
+        uint8_t rgba[160 * 4] = {};
+        kernels->toRgba(indices, lut, rgba, 160);
+        EXPECT_EQ(0, memcmp(expected, rgba, sizeof(rgba))) << kernels->name;
+    }
+}
+}
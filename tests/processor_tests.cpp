@@ -0,0 +1,299 @@
+#include <gtest/gtest.h>
+
+#include "test_system.h"
+
+namespace
+{
+using tests::System;
+
+std::string writeRom(const std::string& name, const std::vector<uint8_t>& code, const std::vector<uint8_t>& handler)
+{
+    std::vector<uint8_t> rom = tests::romWithCode(code);
+    // Same handler for every interrupt.
+    for (uint16_t vector : { 0x40, 0x48, 0x50, 0x58, 0x60 })
+    {
+        std::copy(handler.begin(), handler.end(), rom.begin() + vector);
+    }
+
+    return tests::writeRom(name, rom);
+}
+
+// Runs the code from WRAM followed by push af / pop de, returns F as pushed.
+uint8_t runPushingF(System& system, std::vector<uint8_t> code)
+{
+    code.insert(code.end(), { 0xF5, 0xD1 });  // push af; pop de
+    for (size_t i = 0; i < code.size(); i++)
+    {
+        system.memory.write8((uint16_t)(0xC000 + i), code[i]);
+    }
+    system.registers.setPC(0xC000);
+    while (system.registers.getPC() != 0xC000 + code.size())
+    {
+        system.processor.runNextInstruction(false);
+    }
+
+    uint8_t f = system.registers.read8<cpu::Registers::E>();
+    EXPECT_EQ(system.registers.read8<cpu::Registers::F>(), f);
+    EXPECT_EQ(system.registers.read8<cpu::Registers::D>(), system.registers.read8<cpu::Registers::A>());
+    return f;
+}
+
+uint8_t toF(int result, bool n, bool h, bool c)
+{
+    return ((result & 0xFF) == 0 ? 0x80 : 0) | (n ? 0x40 : 0) | (h ? 0x20 : 0) | (c ? 0x10 : 0);
+}
+
+const std::vector<uint8_t> operands = {
+    0x00, 0x01, 0x09, 0x0F, 0x10, 0x1F, 0x42, 0x7F, 0x80, 0x8F, 0x99, 0x9A, 0xA5, 0xF0, 0xFE, 0xFF
+};
+
+TEST(ProcessorTests, arithmeticFlags)
+{
+    auto system = std::make_unique<System>(writeRom("arithmetic_flags", {}, {}));
+    enum Op : uint8_t { Add = 0x80, Adc = 0x88, Sub = 0x90, Sbc = 0x98, Cp = 0xB8 };  // op a, b
+
+    for (Op op : { Add, Adc, Sub, Sbc, Cp })
+    {
+        for (int a : operands)
+        {
+            for (int b : operands)
+            {
+                for (int carry : { 0, 1 })
+                {
+                    int c = (op == Adc || op == Sbc) ? carry : 0;
+                    bool sub = op != Add && op != Adc;
+                    int result = sub ? a - b - c : a + b + c;
+                    bool h = sub ? (a & 0x0F) < (b & 0x0F) + c : (a & 0x0F) + (b & 0x0F) + c > 0x0F;
+                    bool carryOut = sub ? a < b + c : result > 0xFF;
+
+                    uint8_t f = runPushingF(*system, {
+                        0x3E, (uint8_t)a,               // ld a, a
+                        0x06, (uint8_t)b,               // ld b, b
+                        0x37,                           // scf
+                        carry ? (uint8_t)0x00 : (uint8_t)0x3F,  // nop / ccf
+                        op
+                    });
+
+                    EXPECT_EQ(f, toF(result, sub, h, carryOut))
+                        << "op 0x" << std::hex << (int)op << " a 0x" << a << " b 0x" << b << " carry " << carry;
+                    EXPECT_EQ(system->registers.read8<cpu::Registers::A>(), op == Cp ? a : (result & 0xFF));
+                }
+            }
+        }
+    }
+}
+
+TEST(ProcessorTests, daaFlags)
+{
+    auto system = std::make_unique<System>(writeRom("daa_flags", {}, {}));
+
+    for (bool sub : { false, true })
+    {
+        for (int a : operands)
+        {
+            for (int b : operands)
+            {
+                int result = sub ? a - b : a + b;
+                bool h = sub ? (a & 0x0F) < (b & 0x0F) : (a & 0x0F) + (b & 0x0F) > 0x0F;
+                bool c = sub ? a < b : result > 0xFF;
+                result &= 0xFF;
+
+                if (!sub)
+                {
+                    if (c || result > 0x99)
+                    {
+                        result += 0x60;
+                        c = true;
+                    }
+                    if (h || (result & 0x0F) > 0x09)
+                    {
+                        result += 0x06;
+                    }
+                }
+                else
+                {
+                    if (c)
+                    {
+                        result -= 0x60;
+                    }
+                    if (h)
+                    {
+                        result -= 0x06;
+                    }
+                }
+
+                uint8_t f = runPushingF(*system, {
+                    0x3E, (uint8_t)a,                   // ld a, a
+                    0x06, (uint8_t)b,                   // ld b, b
+                    sub ? (uint8_t)0x90 : (uint8_t)0x80,  // sub b / add b
+                    0x27                                // daa
+                });
+
+                EXPECT_EQ(f, toF(result, sub, false, c))
+                    << (sub ? "sub" : "add") << " a 0x" << std::hex << a << " b 0x" << b;
+                EXPECT_EQ(system->registers.read8<cpu::Registers::A>(), result & 0xFF);
+            }
+        }
+    }
+}
+
+TEST(ProcessorTests, pushPopAF)
+{
+    auto system = std::make_unique<System>(writeRom("push_pop_af", {}, {}));
+
+    for (int f = 0; f < 0x100; f++)
+    {
+        uint8_t pushed = runPushingF(*system, {
+            0x01, (uint8_t)f, 0x5A,             // ld bc, 0x5A00 | f
+            0xC5,                               // push bc
+            0xF1                                // pop af
+        });
+
+        EXPECT_EQ(pushed, f & 0xF0);
+        EXPECT_EQ(system->registers.read8<cpu::Registers::A>(), 0x5A);
+    }
+}
+
+TEST(ProcessorTests, haltSkipsToVBlank)
+{
+    std::string romPath = writeRom("halt_vblank", {
+        0x3E, 0x01,       // ld a, 0x01
+        0xE0, 0xFF,       // ldh (0xFF), a  ; IE = VBlank
+        0xFB,             // ei
+        0x76,             // 0x105: halt
+        0x18, 0xFD        // jr 0x105
+    }, {
+        0x04,             // inc b
+        0xD9              // reti
+    });
+    auto system = std::make_unique<System>(romPath);
+
+    int steps = 0;
+    while (system->registers.read8<cpu::Registers::B>() < 2 && steps < 10000)
+    {
+        system->processor.runNextInstruction(false);
+        steps++;
+    }
+
+    EXPECT_EQ(system->registers.read8<cpu::Registers::B>(), 2);
+    // Two frames, in far fewer steps than cycles.
+    EXPECT_GE(system->processor.getCycles(), 70224 / 4);
+    EXPECT_LE(system->processor.getCycles(), 2 * 70224 / 4 + 16);
+    EXPECT_LT(steps, 2000);
+}
+
+TEST(ProcessorTests, interruptAcknowledgedDuringDma)
+{
+    auto system = std::make_unique<System>(writeRom("interrupt_dma", {}, {}));
+    Memory& memory = system->memory;
+    memory.write8(0xFFFF, 0x01);
+    memory.requestInterrupt(0);
+
+    // IF isn't on the bus while DMA runs, the stack is in HRAM.
+    memory.write8(0xFF46, 0xC1);
+    system->processor.handleInterrupt(cpu::Interrupt::VBlank);
+    EXPECT_EQ(system->registers.getPC(), 0x40);
+    EXPECT_EQ(memory.pendingInterrupts(), 0);
+    EXPECT_EQ(memory.read8(0xFFFD), 0x01);
+    EXPECT_EQ(memory.read8(0xFFFC), 0x00);
+
+    memory.getScheduler().advance(160 * 4);
+    EXPECT_EQ(memory.read8(0xFF0F) & 0x01, 0);
+}
+
+TEST(ProcessorTests, haltSkipsToTimerOverflow)
+{
+    std::string romPath = writeRom("halt_timer", {
+        0x3E, 0x04,       // ld a, 0x04
+        0xE0, 0xFF,       // ldh (0xFF), a  ; IE = Timer
+        0x3E, 0xF0,       // ld a, 0xF0
+        0xE0, 0x05,       // ldh (0x05), a  ; TIMA
+        0x3E, 0x05,       // ld a, 0x05
+        0xE0, 0x07,       // ldh (0x07), a  ; TAC = enabled, 16 T-cycles
+        0xFB,             // ei
+        0x76,             // 0x10D: halt
+        0x18, 0xFD        // jr 0x10D
+    }, {
+        0x04,             // inc b
+        0xD9              // reti
+    });
+    auto system = std::make_unique<System>(romPath);
+
+    int steps = 0;
+    while (system->registers.read8<cpu::Registers::B>() < 1 && steps < 10000)
+    {
+        system->processor.runNextBlock();
+        steps++;
+    }
+
+    EXPECT_EQ(system->registers.read8<cpu::Registers::B>(), 1);
+    EXPECT_LT(steps, 20);
+}
+
+TEST(ProcessorTests, haltWakesWithoutIME)
+{
+    std::string romPath = writeRom("halt_no_ime", {
+        0x3E, 0x01,       // ld a, 0x01
+        0xE0, 0xFF,       // ldh (0xFF), a  ; IE = VBlank
+        0x76,             // halt
+        0x06, 0x2A,       // 0x105: ld b, 0x2A
+        0x18, 0xFE        // 0x107: jr 0x107
+    }, {
+        0x0E, 0xFF,       // ld c, 0xFF
+        0xD9              // reti
+    });
+    auto system = std::make_unique<System>(romPath);
+
+    for (int i = 0; i < 10000 && system->registers.getPC() != 0x107; i++)
+    {
+        system->processor.runNextInstruction(false);
+    }
+
+    EXPECT_EQ(system->registers.getPC(), 0x107);
+    EXPECT_EQ(system->registers.read8<cpu::Registers::B>(), 0x2A);
+    // Not serviced
+    EXPECT_EQ(system->registers.read8<cpu::Registers::C>(), 0x00);
+}
+
+TEST(ProcessorTests, idleLoopSkipsToEvent)
+{
+    // Waits for two VBlanks polling LY.
+    std::string romPath = writeRom("idle_ly", {
+        0x06, 0x02,       // ld b, 2
+        0xF0, 0x44,       // 0x102: ldh a, (0x44)  ; LY
+        0xFE, 0x90,       // cp 0x90
+        0x20, 0xFA,       // jr nz, 0x102
+        0xF0, 0x44,       // 0x108: ldh a, (0x44)
+        0xFE, 0x90,       // cp 0x90
+        0x28, 0xFA,       // jr z, 0x108
+        0x05,             // dec b
+        0x20, 0xF1,       // jr nz, 0x102
+        0x18, 0xFE        // 0x111: jr 0x111
+    }, {
+        0xD9              // reti
+    });
+
+    auto interpreted = std::make_unique<System>(romPath);
+    auto skipped = std::make_unique<System>(romPath);
+
+    for (int i = 0; i < 1000000 && interpreted->registers.getPC() != 0x111; i++)
+    {
+        interpreted->processor.runNextInstruction(false);
+    }
+    int steps = 0;
+    while (skipped->registers.getPC() != 0x111 && steps < 1000000)
+    {
+        skipped->processor.runNextBlock();
+        steps++;
+    }
+
+    ASSERT_EQ(interpreted->registers.getPC(), 0x111);
+    ASSERT_EQ(skipped->registers.getPC(), 0x111);
+    EXPECT_EQ(interpreted->processor.getCycles(), skipped->processor.getCycles());
+    EXPECT_EQ(interpreted->registers.read16<cpu::Registers::AF>(), skipped->registers.read16<cpu::Registers::AF>());
+
+    EXPECT_EQ(interpreted->processor.getIdleCyclesSkipped(), 0u);
+    EXPECT_GT(skipped->processor.getIdleCyclesSkipped(), skipped->processor.getCycles() / 2);
+    EXPECT_LT(steps, 2000);
+}
+}
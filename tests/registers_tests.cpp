@@ -35,7 +35,8 @@ TEST(RegistersTests, writeAndRead8)
 	registers.write8<cpu::Registers::L>(val);
 
 	EXPECT_EQ(registers.read8<cpu::Registers::A>(), val);
-	EXPECT_EQ(registers.read8<cpu::Registers::F>(), val);
+	// The low nibble of F always reads 0.
+	EXPECT_EQ(registers.read8<cpu::Registers::F>(), val & 0xF0);
 	EXPECT_EQ(registers.read8<cpu::Registers::B>(), val);
 	EXPECT_EQ(registers.read8<cpu::Registers::C>(), val);
 	EXPECT_EQ(registers.read8<cpu::Registers::D>(), val);
@@ -56,12 +57,50 @@ TEST(RegistersTests, writeAndRead16)
 	registers.write16<cpu::Registers::DE>(val);
 	registers.write16<cpu::Registers::HL>(val);
 
-	EXPECT_EQ(registers.read16<cpu::Registers::AF>(), val);
+	EXPECT_EQ(registers.read16<cpu::Registers::AF>(), val & 0xFFF0);
 	EXPECT_EQ(registers.read16<cpu::Registers::BC>(), val);
 	EXPECT_EQ(registers.read16<cpu::Registers::DE>(), val);
 	EXPECT_EQ(registers.read16<cpu::Registers::HL>(), val);
 }
 
+TEST(RegistersTests, readBackF)
+{
+	using flag = cpu::Registers::Flag;
+	cpu::Registers r;
+	for (int val = 0; val < 0x100; val++)
+	{
+		r.write8<cpu::Registers::F>((uint8_t)val);
+
+		EXPECT_EQ(r.read8<cpu::Registers::F>(), val & 0xF0);
+		EXPECT_EQ(r.isSetFlag(flag::Z), (val & 0x80) != 0);
+		EXPECT_EQ(r.isSetFlag(flag::N), (val & 0x40) != 0);
+		EXPECT_EQ(r.isSetFlag(flag::H), (val & 0x20) != 0);
+		EXPECT_EQ(r.isSetFlag(flag::C), (val & 0x10) != 0);
+	}
+}
+
+TEST(RegistersTests, readBackFAfterOperation)
+{
+	cpu::Registers r;
+
+	// 0x0F + 0xF1 = 0x100
+	r.setFlags(0x00, false, 0x0F ^ 0xF1 ^ 0x100);
+	EXPECT_EQ(r.read8<cpu::Registers::F>(), 0xB0);
+
+	// inc keeps C
+	r.setFlagsKeepCarry(0x01, false, 0x00 ^ 0x01 ^ 0x01);
+	EXPECT_EQ(r.read8<cpu::Registers::F>(), 0x10);
+
+	// 16-bit add keeps Z
+	r.setFlags(0, false, 0);
+	r.setFlagsKeepZero(false, 0x100);
+	EXPECT_EQ(r.read8<cpu::Registers::F>(), 0x90);
+
+	uint8_t f = r.read8<cpu::Registers::F>();
+	r.write8<cpu::Registers::F>(f);
+	EXPECT_EQ(r.read8<cpu::Registers::F>(), f);
+}
+
 struct test
 {
 	std::vector<std::pair<cpu::Registers::Flag, bool>> operations;
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "utils/scheduler.h"
+
+#include <vector>
+
+namespace
+{
+
+TEST(SchedulerTests, runsEventsInTimestampOrder)
+{
+	utils::Scheduler scheduler;
+	std::vector<std::pair<utils::Event, uint64_t>> ran;
+	for (utils::Event event : { utils::Event::Timer, utils::Event::PPU, utils::Event::DMA, utils::Event::Serial })
+	{
+		scheduler.setHandler(event, [&ran, event](uint64_t timestamp) { ran.emplace_back(event, timestamp); });
+	}
+
+	scheduler.schedule(utils::Event::Serial, 40);
+	scheduler.schedule(utils::Event::Timer, 10);
+	scheduler.schedule(utils::Event::PPU, 30);
+	scheduler.schedule(utils::Event::DMA, 20);
+	EXPECT_EQ(scheduler.nextTimestamp(), 10u);
+
+	scheduler.advance(9);
+	EXPECT_TRUE(ran.empty());
+
+	scheduler.advance(25);
+	ASSERT_EQ(ran.size(), 3u);
+	EXPECT_EQ(ran[0], std::make_pair(utils::Event::Timer, uint64_t(10)));
+	EXPECT_EQ(ran[1], std::make_pair(utils::Event::DMA, uint64_t(20)));
+	EXPECT_EQ(ran[2], std::make_pair(utils::Event::PPU, uint64_t(30)));
+	EXPECT_TRUE(scheduler.isScheduled(utils::Event::Serial));
+	EXPECT_EQ(scheduler.nextTimestamp(), 40u);
+}
+
+TEST(SchedulerTests, rescheduleAndCancel)
+{
+	utils::Scheduler scheduler;
+	int timerRuns = 0;
+	int dmaRuns = 0;
+	scheduler.setHandler(utils::Event::Timer, [&](uint64_t) { timerRuns++; });
+	scheduler.setHandler(utils::Event::DMA, [&](uint64_t) { dmaRuns++; });
+
+	scheduler.schedule(utils::Event::Timer, 10);
+	scheduler.schedule(utils::Event::DMA, 15);
+	scheduler.schedule(utils::Event::Timer, 100);
+	scheduler.cancel(utils::Event::DMA);
+	EXPECT_FALSE(scheduler.isScheduled(utils::Event::DMA));
+
+	scheduler.advance(50);
+	EXPECT_EQ(timerRuns, 0);
+	EXPECT_EQ(dmaRuns, 0);
+
+	scheduler.advance(50);
+	EXPECT_EQ(timerRuns, 1);
+	EXPECT_EQ(scheduler.nextTimestamp(), utils::Scheduler::never);
+}
+
+TEST(SchedulerTests, handlerCanScheduleItself)
+{
+	utils::Scheduler scheduler;
+	int runs = 0;
+	scheduler.setHandler(utils::Event::PPU, [&](uint64_t timestamp)
+	{
+		runs++;
+		scheduler.schedule(utils::Event::PPU, timestamp + 456);
+	});
+	scheduler.schedule(utils::Event::PPU, 456);
+
+	scheduler.advance(456 * 10);
+	EXPECT_EQ(runs, 10);
+	EXPECT_EQ(scheduler.nextTimestamp(), 456u * 11);
+}
+}
@@ -0,0 +1,484 @@
+#include <gtest/gtest.h>
+
+#include "test_system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace
+{
+struct System : tests::System
+{
+    System() :
+        tests::System(tests::writeRom("screen", std::vector<uint8_t>(0x8000, 0)))
+    {
+        memory.write8(0xFF47, 0xE4); // Identity palettes
+        memory.write8(0xFF48, 0xE4);
+        memory.write8(0xFF49, 0x1B);
+    }
+
+    // Tile whose every row has the given color ids.
+    void writeTile(uint16_t addr, const uint8_t (&colorIds)[8])
+    {
+        uint8_t low = 0;
+        uint8_t high = 0;
+        for (int x = 0; x < 8; x++)
+        {
+            low |= (colorIds[x] & 1) << (7 - x);
+            high |= (colorIds[x] >> 1) << (7 - x);
+        }
+        for (int row = 0; row < 8; row++)
+        {
+            memory.write8(addr + row * 2, low);
+            memory.write8(addr + row * 2 + 1, high);
+        }
+    }
+
+    void renderLines(int nbLines)
+    {
+        memory.getScheduler().advance(456 * nbLines);
+    }
+
+    // 0 white to 3 black
+    uint8_t shade(int x, int y)
+    {
+        return screen.getFrameBuffer()[y * video::SCREEN_WIDTH + x];
+    }
+};
+
+TEST(ScreenTests, backgroundScroll)
+{
+    auto system = std::make_unique<System>();
+    EXPECT_EQ(system->memory.read8(0xFF40), 0x91);
+    system->writeTile(0x8010, { 0, 1, 2, 3, 3, 2, 1, 0 });
+    system->memory.write8(0x9801, 1);
+    system->memory.write8(0xFF43, 5); // SCX
+    system->memory.write8(0xFF40, 0x91);
+    system->renderLines(1);
+
+    // Pixel x shows background pixel x + 5, tile 1 spans 3-10.
+    EXPECT_EQ(system->shade(0, 0), 0);
+    EXPECT_EQ(system->shade(3, 0), 0);
+    EXPECT_EQ(system->shade(4, 0), 1);
+    EXPECT_EQ(system->shade(6, 0), 3);
+    EXPECT_EQ(system->shade(9, 0), 1);
+    EXPECT_EQ(system->shade(10, 0), 0);
+    EXPECT_EQ(system->shade(159, 0), 0);
+}
+
+TEST(ScreenTests, signedTileData)
+{
+    auto system = std::make_unique<System>();
+    system->writeTile(0x8800, { 3, 3, 3, 3, 3, 3, 3, 3 }); // Tile -128
+    system->writeTile(0x9000, { 2, 2, 2, 2, 2, 2, 2, 2 }); // Tile 0
+    system->memory.write8(0x9800, 0x80);
+    system->memory.write8(0xFF40, 0x81);
+    system->renderLines(1);
+
+    EXPECT_EQ(system->shade(0, 0), 3);
+    EXPECT_EQ(system->shade(8, 0), 2);
+}
+
+TEST(ScreenTests, tileDataWrites)
+{
+    auto system = std::make_unique<System>();
+    system->writeTile(0x8000, { 1, 1, 1, 1, 1, 1, 1, 1 });
+    system->renderLines(1);
+    EXPECT_EQ(system->shade(0, 0), 1);
+
+    // The decoded tile is dropped when its data changes.
+    system->writeTile(0x8000, { 3, 0, 0, 0, 0, 0, 0, 3 });
+    system->renderLines(1);
+    EXPECT_EQ(system->shade(0, 1), 3);
+    EXPECT_EQ(system->shade(1, 1), 0);
+    EXPECT_EQ(system->shade(7, 1), 3);
+}
+
+TEST(ScreenTests, windowCoversBackground)
+{
+    auto system = std::make_unique<System>();
+    system->writeTile(0x8010, { 1, 1, 1, 1, 1, 1, 1, 1 });
+    system->writeTile(0x8020, { 2, 2, 2, 2, 2, 2, 2, 2 });
+    for (uint16_t i = 0; i < 32 * 32; i++)
+    {
+        system->memory.write8(0x9800 + i, 1);
+        system->memory.write8(0x9C00 + i, 2);
+    }
+    system->memory.write8(0xFF4A, 2);  // WY
+    system->memory.write8(0xFF4B, 87); // WX, window starts at x = 80
+    system->memory.write8(0xFF40, 0xF1);
+    system->renderLines(3);
+
+    EXPECT_EQ(system->shade(100, 1), 1);
+    EXPECT_EQ(system->shade(79, 2), 1);
+    EXPECT_EQ(system->shade(80, 2), 2);
+    EXPECT_EQ(system->shade(159, 2), 2);
+}
+
+TEST(ScreenTests, windowLineCounter)
+{
+    auto system = std::make_unique<System>();
+    system->writeTile(0x8010, { 1, 1, 1, 1, 1, 1, 1, 1 });
+    system->writeTile(0x8020, { 2, 2, 2, 2, 2, 2, 2, 2 });
+    for (uint16_t i = 0; i < 32; i++)
+    {
+        system->memory.write8(0x9C00 + i, 1);
+        system->memory.write8(0x9C20 + i, 2);
+    }
+    system->memory.write8(0xFF4A, 0); // WY
+    system->memory.write8(0xFF4B, 7); // WX
+    system->memory.write8(0xFF40, 0xF1);
+    system->renderLines(4);
+
+    // Lines without window don't move its line counter.
+    system->memory.write8(0xFF40, 0xD1);
+    system->renderLines(8);
+    system->memory.write8(0xFF40, 0xF1);
+    system->renderLines(8);
+
+    EXPECT_EQ(system->shade(0, 3), 1);
+    EXPECT_EQ(system->shade(0, 4), 0);
+    EXPECT_EQ(system->shade(0, 12), 1); // Window line 4
+    EXPECT_EQ(system->shade(0, 15), 1);
+    EXPECT_EQ(system->shade(0, 16), 2); // Window line 8
+
+    // WX is stored as written, past 166 the window is hidden.
+    system->memory.write8(0xFF4B, 167);
+    system->renderLines(1);
+    EXPECT_EQ(system->memory.read8(0xFF4B), 167);
+    EXPECT_EQ(system->shade(0, 20), 0);
+}
+
+TEST(ScreenTests, objectPriority)
+{
+    auto system = std::make_unique<System>();
+    Memory& memory = system->memory;
+    system->writeTile(0x8010, { 1, 1, 1, 1, 1, 1, 1, 1 });
+    system->writeTile(0x8020, { 0, 0, 0, 0, 2, 2, 2, 2 });
+
+    auto writeObject = [&](int index, uint8_t y, uint8_t x, uint8_t tile, uint8_t attributes) {
+        memory.write8(0xFE00 + index * 4, y);
+        memory.write8(0xFE00 + index * 4 + 1, x);
+        memory.write8(0xFE00 + index * 4 + 2, tile);
+        memory.write8(0xFE00 + index * 4 + 3, attributes);
+    };
+    writeObject(0, 16, 12, 1, 0x00);   // x 4-11, color 1
+    writeObject(1, 16, 8, 2, 0x00);    // x 0-7, transparent on 0-3
+    writeObject(2, 16, 40, 2, 0x20);   // x 32-39 flipped, OBP0
+    writeObject(3, 16, 60, 1, 0x10);   // x 52-59, OBP1
+    memory.write8(0xFF40, 0x93);
+    system->renderLines(1);
+
+    // Object 1 has the lower X, object 0 shows through its transparent pixels.
+    EXPECT_EQ(system->shade(0, 0), 0);
+    EXPECT_EQ(system->shade(4, 0), 2);
+    EXPECT_EQ(system->shade(8, 0), 1);
+    EXPECT_EQ(system->shade(32, 0), 2);
+    EXPECT_EQ(system->shade(36, 0), 0);
+    EXPECT_EQ(system->shade(52, 0), 2);
+    EXPECT_EQ(system->shade(60, 0), 0);
+}
+
+TEST(ScreenTests, tallObjectBottomTile)
+{
+    auto system = std::make_unique<System>();
+    system->writeTile(0x8020, { 1, 1, 1, 1, 1, 1, 1, 1 });
+    system->memory.write8(0xFE00, 16); // Lines 0-15
+    system->memory.write8(0xFE01, 8);
+    system->memory.write8(0xFE02, 2);
+    system->memory.write8(0xFF40, 0x97);
+    system->renderLines(1);
+    EXPECT_EQ(system->shade(0, 0), 1);
+
+    // Written once the top tile is cached.
+    system->writeTile(0x8030, { 3, 3, 3, 3, 3, 3, 3, 3 });
+    system->renderLines(15);
+    EXPECT_EQ(system->shade(0, 7), 1);
+    EXPECT_EQ(system->shade(0, 8), 3);
+    EXPECT_EQ(system->shade(0, 15), 3);
+    EXPECT_EQ(system->shade(0, 16), 0);
+}
+
+TEST(ScreenTests, convertFrame)
+{
+    auto system = std::make_unique<System>();
+    system->writeTile(0x8000, { 0, 1, 2, 3, 0, 1, 2, 3 });
+    system->renderLines(1);
+
+    std::vector<uint8_t> gray(video::SCREEN_WIDTH * video::SCREEN_HEIGHT);
+    video::Screen::convertFrame(system->screen.getFrameBuffer(), video::Screen::PixelFormat::Gray8, gray.data());
+    EXPECT_EQ(gray[0], 255);
+    EXPECT_EQ(gray[1], 170);
+    EXPECT_EQ(gray[3], 0);
+
+    std::vector<uint8_t> rgba(video::SCREEN_WIDTH * video::SCREEN_HEIGHT * 4);
+    video::Screen::convertFrame(system->screen.getFrameBuffer(), video::Screen::PixelFormat::Rgba8888, rgba.data());
+    EXPECT_EQ(rgba[2 * 4], 85);
+    EXPECT_EQ(rgba[2 * 4 + 1], 85);
+    EXPECT_EQ(rgba[2 * 4 + 2], 85);
+    EXPECT_EQ(rgba[2 * 4 + 3], 255);
+}
+
+TEST(ScreenTests, framePublishedAtVBlank)
+{
+    auto system = std::make_unique<System>();
+    system->writeTile(0x8000, { 3, 3, 3, 3, 3, 3, 3, 3 });
+    video::FrameExchange& frames = system->screen.getFrames();
+
+    system->renderLines(143);
+    EXPECT_FALSE(frames.hasNewFrame());
+
+    system->renderLines(1);
+    EXPECT_TRUE(frames.hasNewFrame());
+    const uint8_t* frame = frames.acquire();
+    EXPECT_EQ(frame[0], 3);
+    EXPECT_EQ(frame[video::SCREEN_WIDTH * video::SCREEN_HEIGHT - 1], 3);
+    EXPECT_NE(frame, system->screen.getFrameBuffer());
+    EXPECT_FALSE(frames.hasNewFrame());
+}
+
+TEST(ScreenTests, frameExchangeDoesNotTear)
+{
+    constexpr size_t frameWords = 1024;
+    constexpr uint32_t nbFrames = 20000;
+    video::FrameExchange frames(frameWords * sizeof(uint32_t));
+
+    // Frames are filled with their number.
+    std::atomic<bool> done = false;
+    std::thread producer([&]() {
+        uint32_t* buffer = (uint32_t*)frames.getBackBuffer();
+        for (uint32_t frame = 1; frame <= nbFrames; frame++)
+        {
+            std::fill_n(buffer, frameWords, frame);
+            buffer = (uint32_t*)frames.publish();
+        }
+        done = true;
+    });
+
+    // Every frame read is whole and never older than the previous one.
+    uint32_t last = 0;
+    int torn = 0;
+    int older = 0;
+    while (!done || frames.hasNewFrame())
+    {
+        const uint32_t* frame = (const uint32_t*)frames.acquire();
+        if (std::count(frame, frame + frameWords, frame[0]) != frameWords)
+        {
+            torn++;
+        }
+        if (frame[0] < last)
+        {
+            older++;
+        }
+        last = frame[0];
+    }
+    producer.join();
+
+    EXPECT_EQ(torn, 0);
+    EXPECT_EQ(older, 0);
+    EXPECT_EQ(frames.getPublishedFrames(), (uint64_t)nbFrames);
+    EXPECT_EQ(((const uint32_t*)frames.acquire())[0], nbFrames);
+}
+
+TEST(ScreenTests, statComputedOnRead)
+{
+    auto system = std::make_unique<System>();
+    Memory& memory = system->memory;
+    utils::Scheduler& scheduler = memory.getScheduler();
+
+    EXPECT_EQ(memory.read8(0xFF41) & 0x03, 2);
+    scheduler.advance(100);
+    EXPECT_EQ(memory.read8(0xFF41) & 0x03, 3);
+    scheduler.advance(200);
+    EXPECT_EQ(memory.read8(0xFF41) & 0x03, 0);
+
+    // LY=LYC flag follows both registers.
+    memory.write8(0xFF45, 1);
+    EXPECT_FALSE(memory.read8(0xFF41) & 0x04);
+    scheduler.advance(456);
+    EXPECT_EQ(memory.read8(0xFF44), 1);
+    EXPECT_TRUE(memory.read8(0xFF41) & 0x04);
+
+    // Only the enables are writable.
+    memory.write8(0xFF41, 0xFF);
+    EXPECT_EQ(memory.read8(0xFF41) & 0x78, 0x78);
+    memory.write8(0xFF41, 0x00);
+    EXPECT_EQ(memory.read8(0xFF41) & 0x78, 0x00);
+
+    scheduler.advance(456 * 143);
+    EXPECT_EQ(memory.read8(0xFF44), 144);
+    EXPECT_EQ(memory.read8(0xFF41) & 0x03, 1);
+
+    memory.write8(0xFF40, 0x11);
+    EXPECT_EQ(memory.read8(0xFF44), 0);
+    EXPECT_EQ(memory.read8(0xFF41) & 0x03, 0);
+}
+
+TEST(ScreenTests, statWrittenWithoutMemory)
+{
+    video::Screen screen;
+    screen.setLYC(0);
+    screen.setSTAT(0x40);
+    EXPECT_EQ(screen.getSTAT(), 0xC0 | 0x04);
+}
+
+TEST(ScreenTests, statInterruptOnRisingEdge)
+{
+    auto system = std::make_unique<System>();
+    Memory& memory = system->memory;
+    utils::Scheduler& scheduler = memory.getScheduler();
+
+    // HBlank and OAM scan: one interrupt each, mode 3 lowers the line in
+    // between.
+    memory.write8(0xFF41, 0x28);
+    memory.write8(0xFF0F, 0);
+    scheduler.advance(300);
+    EXPECT_EQ(memory.read8(0xFF0F) & 0x02, 0x02);
+
+    memory.write8(0xFF0F, 0);
+    scheduler.advance(456);
+    EXPECT_EQ(memory.read8(0xFF0F) & 0x02, 0x02);
+
+    // Writing the current line to LYC raises it at once, then nothing until
+    // LY matches again.
+    memory.write8(0xFF41, 0x40);
+    memory.write8(0xFF0F, 0);
+    memory.write8(0xFF45, 1);
+    EXPECT_EQ(memory.read8(0xFF0F) & 0x02, 0x02);
+    memory.write8(0xFF0F, 0);
+    scheduler.advance(100);
+    EXPECT_EQ(memory.read8(0xFF0F) & 0x02, 0x00);
+}
+
+TEST(ScreenTests, renderInterval)
+{
+    auto system = std::make_unique<System>();
+    Memory& memory = system->memory;
+    video::Screen& screen = system->screen;
+    system->writeTile(0x8000, { 3, 3, 3, 3, 3, 3, 3, 3 });
+
+    // Headless from frame 1: same timing and interrupts, nothing drawn or
+    // published.
+    screen.setRenderInterval(0);
+    system->renderLines(154);
+    EXPECT_EQ(screen.getFrames().getPublishedFrames(), 1u);
+    memory.write8(0xFF0F, 0);
+    system->renderLines(144);
+    EXPECT_EQ(memory.read8(0xFF0F) & 0x01, 0x01);
+    EXPECT_EQ(memory.read8(0xFF41) & 0x03, 1);
+    EXPECT_EQ(screen.getFrameCount(), 2u);
+    EXPECT_EQ(screen.getFrames().getPublishedFrames(), 1u);
+    EXPECT_EQ(system->shade(0, 0), 0);
+
+    // One frame out of 2 from frame 2 on: frames 2 and 4.
+    screen.setRenderInterval(2);
+    system->renderLines(154 * 3);
+    EXPECT_EQ(screen.getFrameCount(), 5u);
+    EXPECT_EQ(screen.getFrames().getPublishedFrames(), 3u);
+
+    // A requested frame is drawn even when headless.
+    screen.setRenderInterval(0);
+    screen.requestFrame(6);
+    system->renderLines(154 * 2);
+    EXPECT_EQ(screen.getFrameCount(), 7u);
+    EXPECT_EQ(screen.getFrames().getPublishedFrames(), 4u);
+    EXPECT_EQ(screen.getFrames().acquire()[0], 3);
+}
+
+TEST(ScreenTests, unchangedLinesAreSkipped)
+{
+    auto system = std::make_unique<System>();
+    Memory& memory = system->memory;
+    video::Screen& screen = system->screen;
+    video::FrameExchange& frames = screen.getFrames();
+    system->writeTile(0x8010, { 1, 2, 3, 0, 1, 2, 3, 0 });
+    memory.write8(0x9800, 1);
+
+    // Without a consumer the back and middle buffers alternate, each is
+    // drawn once then already holds the frame.
+    system->renderLines(154 * 2);
+    EXPECT_EQ(screen.getDrawnLines(), 144u * 2);
+    system->renderLines(154 * 3);
+    EXPECT_EQ(screen.getDrawnLines(), 144u * 2);
+    frames.acquire();
+    EXPECT_TRUE(frames.getFrontChangedLines().none());
+
+    // A tile map write changes its 8 lines, a tile data write all the lines
+    // showing the tile.
+    memory.write8(0x9821, 1);
+    system->renderLines(154);
+    EXPECT_EQ(screen.getDrawnLines(), 144u * 2 + 8);
+    frames.acquire();
+    EXPECT_EQ(frames.getFrontChangedLines().count(), 8u);
+    EXPECT_TRUE(frames.getFrontChangedLines()[8]);
+    EXPECT_EQ(frames.getFrontNumber(), 6u);
+
+    memory.write8(0x8012, 0xFF);
+    system->renderLines(154);
+    const uint8_t* frame = frames.acquire();
+    EXPECT_EQ(frames.getFrontChangedLines().count(), 16u);
+    EXPECT_TRUE(frames.getFrontChangedLines()[0]);
+    EXPECT_TRUE(frames.getFrontChangedLines()[15]);
+    EXPECT_EQ(frame[video::SCREEN_WIDTH + 1], 3);
+    EXPECT_EQ(frame[video::SCREEN_WIDTH * 9 + 9], 3);
+
+    // Scrolling changes everything.
+    memory.write8(0xFF42, 1);
+    system->renderLines(154);
+    frames.acquire();
+    EXPECT_EQ(frames.getFrontChangedLines().count(), 144u);
+}
+
+TEST(ScreenTests, objectLinesFollowOam)
+{
+    auto system = std::make_unique<System>();
+    Memory& memory = system->memory;
+    system->writeTile(0x8010, { 1, 1, 1, 1, 1, 1, 1, 1 });
+
+    // 12 objects side by side on lines 0-7, only the first 10 in OAM order
+    // are drawn even though the last ones have a lower X.
+    for (int i = 0; i < 12; i++)
+    {
+        memory.write8(0xFE00 + i * 4, 16);
+        memory.write8(0xFE00 + i * 4 + 1, (uint8_t)(8 + (11 - i) * 8));
+        memory.write8(0xFE00 + i * 4 + 2, 1);
+    }
+    memory.write8(0xFF40, 0x93);
+    system->renderLines(1);
+    EXPECT_EQ(system->shade(0, 0), 0);
+    EXPECT_EQ(system->shade(8, 0), 0);
+    EXPECT_EQ(system->shade(16, 0), 1);
+    EXPECT_EQ(system->shade(95, 0), 1);
+
+    // Moving object 0 to line 20 frees a slot for object 10.
+    memory.write8(0xFE00, 36);
+    system->renderLines(1);
+    EXPECT_EQ(system->shade(8, 1), 1);
+    EXPECT_EQ(system->shade(88, 1), 0);
+
+    // 8x16 objects cover 16 lines.
+    system->renderLines(19);
+    EXPECT_EQ(system->shade(88, 20), 1);
+    memory.write8(0xFF40, 0x97);
+    system->renderLines(8);
+    EXPECT_EQ(system->shade(88, 21), 0); // Rows 0-7 use tile 1 & 0xFE, blank
+    EXPECT_EQ(system->shade(88, 28), 1);
+
+    // DMA rewrites every entry.
+    for (uint16_t i = 0; i < 0xA0; i++)
+    {
+        memory.write8(0xC000 + i, 0);
+    }
+    memory.write8(0xC000, 16 + 30);
+    memory.write8(0xC001, 8);
+    memory.write8(0xC002, 1);
+    memory.write8(0xFF40, 0x93);
+    memory.write8(0xFF46, 0xC0);
+    memory.getScheduler().advance(160 * 4);
+    system->renderLines(154 * 2);
+    const uint8_t* frame = system->screen.getFrames().acquire();
+    EXPECT_EQ(frame[30 * video::SCREEN_WIDTH], 1);
+    EXPECT_EQ(frame[2 * video::SCREEN_WIDTH + 16], 0);
+}
+}
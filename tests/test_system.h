@@ -0,0 +1,78 @@
+#pragma once
+
+#include "cpu/processor.h"
+#include "cpu/registery.h"
+#include "memory/cartridge.h"
+#include "memory/memory.h"
+#include "video/screen.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+// Fixture shared by the tests and benchmarks: a ROM written to a temporary
+// file and the emulator running it.
+namespace tests
+{
+// Writes the ROM to a temporary file, returns its path.
+//
+// ROM files are mapped, truncating one that another process (ctest -j) or
+// instance still maps would crash it. Each process gets its own file, and
+// it is replaced through a rename so that existing mappings keep the old one.
+inline std::string writeRom(const std::string& name, const std::vector<uint8_t>& rom)
+{
+#ifdef _WIN32
+    int pid = _getpid();
+#else
+    int pid = getpid();
+#endif
+    auto path = std::filesystem::temp_directory_path() / (name + "_" + std::to_string(pid) + ".gb");
+    auto writing = std::filesystem::path(path).replace_extension(".tmp");
+    {
+        std::ofstream file(writing, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(rom.data()), rom.size());
+    }
+    std::filesystem::rename(writing, path);
+
+    return path.string();
+}
+
+// 32KB ROM without MBC, the code starts at the entry point.
+inline std::vector<uint8_t> romWithCode(const std::vector<uint8_t>& code)
+{
+    std::vector<uint8_t> rom(0x8000, 0);
+    std::copy(code.begin(), code.end(), rom.begin() + 0x100);
+    return rom;
+}
+
+// State after the boot ROM, running from 0x100.
+struct System
+{
+    explicit System(const std::string& romPath) :
+        cartridge(romPath.c_str()),
+        memory(cartridge, registers, screen, ""),
+        processor(registers, memory)
+    {
+        memory.loadROM(romPath.c_str());
+        memory.disableBootRom();
+        screen.setMemory(&memory);
+        registers.setPC(0x100);
+        registers.setSP(0xFFFE);
+    }
+
+    Cartridge cartridge;
+    cpu::Registers registers;
+    video::Screen screen;
+    Memory memory;
+    cpu::Processor processor;
+};
+}